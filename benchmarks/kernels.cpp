@@ -0,0 +1,47 @@
+// Example kernels for the runner: scalar and multi-accumulator reductions over the same input,
+// so `timed_runner --filter=sum_` compares them directly.
+#include "timer.hpp"
+
+
+namespace
+{
+    const std::vector<float>& input()
+    {
+        static const std::vector<float> data(1 << 14, 1.0f);
+        return data;
+    }
+} // namespace
+
+
+TIMED_BENCHMARK(sum_loop)
+{
+    float sum = 0;
+    for (float value : input()) sum += value;
+    Timed::do_not_optimize(sum);
+}
+
+TIMED_BENCHMARK(sum_accumulate)
+{
+    Timed::do_not_optimize(std::accumulate(input().begin(), input().end(), 0.0f));
+}
+
+// four independent accumulators break the dependency chain on the additions
+TIMED_BENCHMARK(sum_four_accumulators)
+{
+    const std::vector<float>& data = input();
+    float sums[4] = {};
+    for (std::size_t i = 0; i + 4 <= data.size(); i += 4) {
+        sums[0] += data[i];
+        sums[1] += data[i + 1];
+        sums[2] += data[i + 2];
+        sums[3] += data[i + 3];
+    }
+    Timed::do_not_optimize(sums[0] + sums[1] + sums[2] + sums[3]);
+}
+
+TIMED_BENCHMARK(string_append)
+{
+    std::string text;
+    for (int i = 0; i < 64; ++i) text += 'x';
+    Timed::do_not_optimize(text);
+}
@@ -0,0 +1,50 @@
+// Recording throughput of Timed::Registry, sharded per CPU, against one shared set of
+// atomics, from 1 to 64 threads. Build with:
+//     g++ -std=c++20 -O2 -pthread -I.. registry_scaling.cpp -o registry_scaling
+// or through the `registry_scaling` CMake target.
+#include "timer.hpp"
+
+
+// The design the Registry replaces: every thread updates the same counters.
+struct SingleAtomic
+{
+    std::atomic<std::uint64_t> count { 0 };
+    std::atomic<int64_t> sum { 0 };
+    std::atomic<int64_t> min { std::numeric_limits<int64_t>::max() };
+    std::atomic<int64_t> max { std::numeric_limits<int64_t>::min() };
+    std::array<std::atomic<std::uint64_t>, Timed::Registry::bucket_count> buckets {};
+
+    void record(int64_t elapsed) noexcept
+    {
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(elapsed, std::memory_order_relaxed);
+        Timed::detail::atomic_min(min, elapsed);
+        Timed::detail::atomic_max(max, elapsed);
+        auto bucket = std::min<std::size_t>(std::bit_width(static_cast<std::uint64_t>(elapsed)), buckets.size() - 1);
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+
+int main()
+{
+    constexpr std::size_t threads = 64;
+    constexpr std::size_t iterations = 200000;
+    std::cout << "Registry shards per site: " << Timed::Registry::get_shard_count() << '\n';
+
+    {
+        const auto location = std::source_location::current();
+        Timed::ThreadedFunctionTimer({{"sharded registry"}, threads, iterations, false, true}, [&] {
+            Timed::Registry::record("scaling", location, 100);
+        });
+    }
+
+    {
+        SingleAtomic single;
+        Timed::ThreadedFunctionTimer({{"single atomic"}, threads, iterations, false, true}, [&] {
+            single.record(100);
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,4 @@
+// The benchmark runner: links with every file declaring TIMED_BENCHMARKs and runs them.
+// `timed_runner --help` lists the options.
+#define TIMED_BENCHMARK_MAIN
+#include "timer.hpp"
@@ -18,6 +18,16 @@ int fibonacci(int n)
 }
 
 
+long long sum_to(long long n)
+{
+    long long result = 0;
+    for (long long i = 0; i < n; ++i) {
+        Timed::do_not_optimize(result += i);
+    }
+    return result;
+}
+
+
 int some_function_that_takes_a_while(int a, int b)
 {
     std::this_thread::sleep_for(std::chrono::seconds(3));
@@ -27,11 +37,20 @@ int some_function_that_takes_a_while(int a, int b)
 int main()
 {
     {
-        Timed::AverageFunctionTimer<10>({{"foo"}}, foo, 1, 2);
+        Timed::AverageFunctionTimer({{"foo"}, 10}, foo, 1, 2);
+    }
+
+    {
+        Timed::FunctionTimer<int, std::chrono::seconds>({"fibonacci"}, fibonacci, 41);
+    }
+
+    {
+        Timed::Benchmark({{"foo (benchmark)"}}, foo, 1, 2);
     }
 
     {
-        Timed::FunctionTimer<std::chrono::seconds>({"fibonacci"}, fibonacci, 41);
+        // Time sum_to for n = 1024 ... 1048576 and report the best-fitting complexity
+        Timed::Sweep({{"sum_to"}, Timed::geometric_range(1 << 10, 1 << 20, 4)}, sum_to);
     }
 
     
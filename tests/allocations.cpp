@@ -0,0 +1,95 @@
+// Per-region heap counters from the TIMED_TRACK_ALLOCATIONS operator new/delete.
+#define TIMED_TRACK_ALLOCATIONS
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <sstream>
+
+
+// `blocks` allocations of `size` bytes, all live at once. Direct operator calls, which unlike
+// new-expressions may not be elided.
+static void allocate_and_free(std::size_t blocks, std::size_t size)
+{
+    std::array<void*, 4> live {};
+    for (std::size_t i = 0; i < blocks; ++i) {
+        live[i] = ::operator new(size);
+        Timed::do_not_optimize(live[i]);
+    }
+    for (std::size_t i = 0; i < blocks; ++i) ::operator delete(live[i]);
+}
+
+
+int main()
+{
+    Timed::detail::BaseTimerSettings settings { "heap", Timed::Format("{allocations} {allocated_bytes} {peak_bytes}"), false };
+    settings.allocations = true;
+
+    {
+        Timed::FunctionTimer timer(settings, [] { allocate_and_free(3, 40); });
+        const Timed::Allocations* allocations = timer.get_allocations();
+        CHECK(allocations != nullptr);
+        if (allocations) {
+            CHECK(allocations->count == 3);
+            CHECK(allocations->bytes == 120);
+            CHECK(allocations->peak_bytes == 120);
+        }
+    }
+
+    {
+        // aligned and array forms are counted too, and freeing first keeps the peak low
+        Timed::FunctionTimer timer(settings, [] {
+            void* aligned = ::operator new(64, std::align_val_t { 64 });
+            Timed::do_not_optimize(aligned);
+            CHECK(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+            ::operator delete(aligned, std::align_val_t { 64 });
+            void* array = ::operator new[](16);
+            Timed::do_not_optimize(array);
+            ::operator delete[](array);
+        });
+        const Timed::Allocations* allocations = timer.get_allocations();
+        CHECK(allocations && allocations->count == 2 && allocations->bytes == 80 && allocations->peak_bytes == 64);
+    }
+
+    {
+        // memory already live at the start does not count towards the region's peak
+        void* held = ::operator new(1000);
+        Timed::do_not_optimize(held);
+        Timed::FunctionTimer timer(settings, [] { allocate_and_free(2, 10); });
+        ::operator delete(held);
+        CHECK(timer.get_allocations() && timer.get_allocations()->peak_bytes == 20);
+    }
+
+    {
+        // a nested region's allocations also belong to the enclosing one
+        Timed::BlockTimer outer(settings);
+        void* first = ::operator new(100);
+        Timed::do_not_optimize(first);
+        {
+            Timed::FunctionTimer inner(settings, [] { allocate_and_free(1, 500); });
+            CHECK(inner.get_allocations() && inner.get_allocations()->count == 1 && inner.get_allocations()->peak_bytes == 500);
+        }
+        ::operator delete(first);
+        outer.end();
+        const Timed::Allocations* allocations = outer.get_allocations();
+        CHECK(allocations && allocations->count == 2 && allocations->bytes == 600 && allocations->peak_bytes == 600);
+    }
+
+    {
+        // per-call averages in the report
+        std::ostringstream out;
+        Timed::detail::BaseTimerSettings shown { "heap", settings.format, true, std::source_location::current(), out };
+        shown.allocations = true;
+        Timed::AverageFunctionTimer<>::Settings average { shown, 4 };
+        { Timed::AverageFunctionTimer<> timer(average, [] { allocate_and_free(2, 8); }); }
+        CHECK(out.str() == "2 16 16\n");
+    }
+
+    {
+        // without the setting nothing is tracked
+        Timed::detail::BaseTimerSettings untracked { "untracked", Timed::Format(""), false };
+        Timed::FunctionTimer timer(untracked, [] { allocate_and_free(1, 8); });
+        CHECK(timer.get_allocations() == nullptr);
+    }
+
+    return check::finish();
+}
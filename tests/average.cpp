@@ -0,0 +1,76 @@
+// AverageFunctionTimer arguments and fixtures.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <thread>
+
+
+int main()
+{
+    using namespace std::chrono_literals;
+    using Timer = Timed::AverageFunctionTimer<>;
+
+    {
+        // a consumed rvalue argument is a fresh copy on every call
+        std::vector<std::size_t> sizes;
+        auto consume = [&](std::vector<int> input) { sizes.push_back(input.size()); };
+        Timer timer({ { "consume", Timed::Format(""), false }, 5 }, consume, std::vector<int>(100, 1));
+        CHECK((sizes == std::vector<std::size_t>(5, 100)));
+    }
+
+    {
+        // moving out of an rvalue reference does not empty the next call's argument either
+        std::vector<std::size_t> sizes;
+        auto steal = [&](std::string&& input) {
+            std::string stolen = std::move(input);
+            sizes.push_back(stolen.size());
+        };
+        Timer timer({ { "steal", Timed::Format(""), false }, 5 }, steal, std::string(64, 'x'));
+        CHECK((sizes == std::vector<std::size_t>(5, 64)));
+    }
+
+    {
+        // lvalue arguments are passed by reference, so calls see each other's changes
+        int calls = 0;
+        Timer timer({ { "lvalue", Timed::Format(""), false }, 5 }, [](int& counter) { ++counter; }, calls);
+        CHECK(calls == 5);
+    }
+
+    {
+        // the setup's value is passed first, then to the teardown; neither is timed
+        int setups = 0, teardowns = 0;
+        std::vector<std::size_t> sizes;
+        Timed::Fixture fixture {
+            [&] {
+                ++setups;
+                std::this_thread::sleep_for(5ms);
+                return std::vector<int>(10, 2);
+            },
+            [&](std::vector<int>& input) {
+                ++teardowns;
+                CHECK(input.empty()); // the callable took it as an rvalue
+                std::this_thread::sleep_for(5ms);
+            },
+        };
+        Timer timer({ { "fixture", Timed::Format(""), false }, 5 }, fixture,
+                    [&](std::vector<int>&& input, int extra) {
+                        sizes.push_back(input.size() + static_cast<std::size_t>(extra));
+                        std::vector<int> taken = std::move(input);
+                    }, 1);
+        CHECK(setups == 5);
+        CHECK(teardowns == 5);
+        CHECK((sizes == std::vector<std::size_t>(5, 11)));
+        // 50 ms were spent in the fixture
+        CHECK(timer.get_total_time() < 5'000'000);
+    }
+
+    {
+        // a setup returning nothing still runs around every call
+        int setups = 0, calls = 0;
+        Timer timer({ { "void setup", Timed::Format(""), false }, 3 }, Timed::Fixture { [&] { ++setups; } }, [&] { ++calls; });
+        CHECK(setups == 3);
+        CHECK(calls == 3);
+    }
+
+    return check::finish();
+}
@@ -0,0 +1,71 @@
+// Benchmark batch sizing and its error bound.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+static int add(int a, int b) { return a + b; }
+
+static int spin()
+{
+    volatile int sum = 0;
+    for (int i = 0; i < 64; ++i) sum = sum + i;
+    return sum;
+}
+
+
+int main()
+{
+    {
+        using Fast = Timed::Benchmark<Timed::automatic_duration, std::chrono::steady_clock, 8>;
+        Fast::Settings settings { { "add" } };
+        settings.show_output = false;
+        settings.warmup = std::chrono::milliseconds(1);
+        settings.samples = 10;
+        // a batch of a few clock ticks would already exceed the resolution
+        settings.resolution_multiple = 1;
+        settings.max_clock_overhead = 0.001;
+        Fast benchmark(settings, add, 1, 2);
+
+        // the batch was grown until the clock cost is at most ~0.1% of it
+        const double batch_time = static_cast<double>(benchmark.get_batch_size())
+                                * (benchmark.get_median_time() + benchmark.get_loop_overhead());
+        CHECK(benchmark.get_batch_size() % 8 == 0);
+        CHECK(benchmark.get_clock_overhead() > 0);
+        CHECK(batch_time >= 0.5 * benchmark.get_clock_overhead() / settings.max_clock_overhead);
+
+        // the error bound includes the clock terms over the batch
+        CHECK(benchmark.get_clock_error() == (benchmark.get_clock_resolution() + benchmark.get_clock_overhead())
+                                                 / static_cast<double>(benchmark.get_batch_size()));
+        CHECK(benchmark.get_error() >= benchmark.get_clock_error());
+        CHECK(benchmark.get_samples().size() == 10);
+        CHECK(benchmark.get_iterations() == 10 * benchmark.get_batch_size());
+    }
+
+    {
+        // without the overhead target only the resolution sizes the batch
+        Timed::Benchmark<>::Settings settings { { "add" } };
+        settings.show_output = false;
+        settings.warmup = std::chrono::milliseconds(1);
+        settings.samples = 5;
+        settings.resolution_multiple = 1;
+        settings.max_clock_overhead = 0;
+        Timed::Benchmark<> small(settings, add, 1, 2);
+        settings.max_clock_overhead = 0.0001;
+        Timed::Benchmark<> large(settings, add, 1, 2);
+        CHECK(small.get_batch_size() < large.get_batch_size());
+    }
+
+    {
+        // the empty loop mirrors the timed one, so only the call itself is left once it is
+        // subtracted: the work of `spin` must not vanish into an inflated loop overhead
+        Timed::Benchmark<>::Settings settings { { "spin" } };
+        settings.show_output = false;
+        settings.warmup = std::chrono::milliseconds(1);
+        settings.samples = 5;
+        Timed::Benchmark<> benchmark(settings, spin);
+        CHECK(benchmark.get_median_time() > 0);
+        CHECK(benchmark.get_loop_overhead() < benchmark.get_median_time());
+    }
+
+    return check::finish();
+}
@@ -0,0 +1,123 @@
+// Varint encoding and BinaryWriter/BinaryReader round-trips.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <cstdio>
+
+
+int main()
+{
+    using namespace Timed::detail::binary;
+
+    {
+        const std::uint64_t values[] = { 0, 1, 127, 128, 300, 16383, 16384, std::uint64_t(1) << 35,
+                                         std::numeric_limits<std::uint64_t>::max() };
+        std::string out;
+        for (auto value : values) put_varint(out, value);
+        CHECK(out.size() == 1 + 1 + 1 + 2 + 2 + 2 + 3 + 6 + 10);
+
+        const char* at = out.data();
+        for (auto value : values) CHECK(get_varint(at, out.data() + out.size()) == value);
+        CHECK(at == out.data() + out.size());
+    }
+
+    {
+        const int64_t values[] = { 0, -1, 1, -64, 64, -1'000'000'007, std::numeric_limits<int64_t>::min(),
+                                   std::numeric_limits<int64_t>::max() };
+        std::string out;
+        for (auto value : values) put_zigzag(out, value);
+        CHECK(static_cast<unsigned char>(out[1]) == 1); // -1 encodes as 1
+
+        const char* at = out.data();
+        for (auto value : values) CHECK(get_zigzag(at, out.data() + out.size()) == value);
+    }
+
+    {
+        // a truncated buffer decodes as far as it goes instead of overrunning
+        std::string out;
+        put_varint(out, 1'000'000);
+        const char* at = out.data();
+        get_varint(at, out.data() + 1);
+        CHECK(at == out.data() + 1);
+    }
+
+    const std::string path = "timed_test_binary.bin";
+    const auto here = std::source_location::current();
+    constexpr int records = 10000;
+    {
+        // small blocks so the records span several of them, with start deltas going backwards
+        Timed::BinaryWriter writer(path, { 1000, 64 });
+        CHECK(writer.is_open());
+        for (int i = 0; i < records; ++i)
+            writer.write(Timed::Record { i % 3 ? "even" : "odd", here, 1000 * i - (i % 7) * 5000, 1000 * i + i % 100 });
+
+        Timed::Registry::Summary summary { "summary", here, 5, 150, 10, 60 };
+        summary.buckets[4] = 2;
+        summary.buckets[6] = 3;
+        writer.write({ summary });
+        writer.write({ { "picoseconds", here, 2, 1500, 500, 1000 } }, 1000);
+    }
+    {
+        Timed::BinaryReader reader(path);
+        CHECK(reader.is_open());
+        CHECK(reader.get_version() == 2);
+        CHECK(reader.get_sites().size() == 4);
+        CHECK(reader.get_sites()[0].name == "odd");
+        CHECK(reader.get_sites()[1].name == "even");
+        CHECK(reader.get_sites()[0].line == here.line());
+        CHECK(reader.get_sites()[0].file == here.file_name());
+
+        int i = 0;
+        bool matches = true;
+        for (const auto& entry : reader) {
+            const int64_t start = 1000 * i - (i % 7) * 5000;
+            matches &= entry.site == (i % 3 ? 1u : 0u);
+            matches &= entry.start == start;
+            matches &= entry.duration == 1000 * i + i % 100 - start;
+            ++i;
+        }
+        CHECK(matches);
+        CHECK(i == records);
+
+        CHECK(reader.get_summaries().size() == 2);
+        const auto& summary = reader.get_summaries()[0];
+        CHECK(reader.get_sites()[summary.site].name == "summary");
+        CHECK(summary.scale == 1);
+        CHECK(summary.count == 5);
+        CHECK(summary.sum == 150);
+        CHECK(summary.min == 10);
+        CHECK(summary.max == 60);
+        CHECK(summary.buckets[4] == 2);
+        CHECK(summary.buckets[6] == 3);
+
+        const auto& fine = reader.get_summaries()[1];
+        CHECK(reader.get_sites()[fine.site].name == "picoseconds");
+        CHECK(fine.scale == 1000);
+        CHECK(fine.count == 2);
+        CHECK(fine.sum == 1500);
+        CHECK(fine.max == 1000);
+    }
+    {
+        // version 1 summaries have no scale and read as nanoseconds
+        std::string file(magic_v1), payload;
+        for (std::uint64_t value : { 0, 3, 60, 20, 30, 0 }) put_varint(payload, value);
+        file += static_cast<char>(Chunk::summary);
+        put_varint(file, payload.size());
+        file += payload;
+        std::FILE* out = std::fopen(path.c_str(), "wb");
+        std::fwrite(file.data(), 1, file.size(), out);
+        std::fclose(out);
+
+        Timed::BinaryReader reader(path);
+        CHECK(reader.get_version() == 1);
+        CHECK(reader.get_summaries().size() == 1);
+        CHECK(reader.get_summaries()[0].scale == 1);
+        CHECK(reader.get_summaries()[0].count == 3);
+        CHECK(reader.get_summaries()[0].sum == 30);
+    }
+    std::remove(path.c_str());
+
+    CHECK(!Timed::BinaryReader("timed_test_missing.bin").is_open());
+
+    return check::finish();
+}
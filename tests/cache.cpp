@@ -0,0 +1,64 @@
+// CacheBenchmark hot and cold runs.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <sstream>
+
+
+int main()
+{
+    {
+        // the warm-up, hot and cold calls are never mixed into one destination
+        std::vector<int> data(1 << 12, 1);
+        Timed::Histogram histogram;
+        Timed::Baseline baseline;
+        Timed::CacheBenchmark<>::Settings settings { { "cache mixed" }, 5, { { data.data(), data.size() * sizeof(int) } } };
+        settings.show_output = false;
+        settings.record = true;
+        settings.histogram = &histogram;
+        settings.baseline = &baseline;
+        Timed::CacheBenchmark benchmark(settings, [&] { return std::accumulate(data.begin(), data.end(), 0); });
+
+        CHECK(benchmark.get_hot_statistics().count() == 5);
+        CHECK(benchmark.get_cold_statistics().count() == 5);
+        CHECK(histogram.snapshot().get_count() == 0);
+        CHECK(baseline.get_names().empty());
+        bool recorded = false;
+        for (const auto& summary : Timed::Registry::snapshot()) recorded |= summary.name == "cache mixed";
+        CHECK(!recorded);
+    }
+
+    {
+        // reading one int per cache line of 256 KiB is far slower once the lines are flushed
+        std::vector<int> data(1 << 16, 1);
+        int calls = 0;
+        auto sum = [&] {
+            ++calls;
+            long total = 0;
+            for (std::size_t i = 0; i < data.size(); i += 16) total += data[i];
+            return total;
+        };
+        std::ostringstream out;
+        Timed::CacheBenchmark<>::Settings settings { { "flush", Timed::Format("{result}"), true, std::source_location::current(), out },
+                                                     21, { Timed::MemoryRange(data) } };
+        {
+            Timed::CacheBenchmark benchmark(settings, sum);
+            CHECK(calls == 1 + 21 + 21); // warm-up, hot and cold calls
+            CHECK(benchmark.get_hot_statistics().count() == 21);
+            CHECK(benchmark.get_cold_time() > benchmark.get_hot_time());
+            CHECK(benchmark.get_cold_ratio() > 1.5);
+            CHECK(benchmark.get_cold_ratio() == static_cast<double>(benchmark.get_cold_time()) / static_cast<double>(benchmark.get_hot_time()));
+        }
+        const std::string line = out.str();
+        CHECK(line.starts_with("hot "));
+        CHECK(line.find(", cold ") != std::string::npos);
+        CHECK(line.ends_with("x)\n"));
+
+        // without ranges the caches are evicted by streaming through a buffer
+        Timed::CacheBenchmark<>::Settings streamed { { "evict", Timed::Format(""), false }, 11, {}, std::size_t(16) << 20 };
+        Timed::CacheBenchmark evicted(streamed, sum);
+        CHECK(evicted.get_cold_ratio() > 1.5);
+    }
+
+    return check::finish();
+}
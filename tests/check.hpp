@@ -0,0 +1,25 @@
+// Minimal assertions shared by the tests: a failed check prints its location and expression,
+// and `finish()` turns any failure into a non-zero exit status for ctest.
+#pragma once
+#include <iostream>
+
+
+namespace check
+{
+    inline int failures = 0;
+
+    inline void report(bool passed, const char* expression, const char* file, int line)
+    {
+        if (passed) return;
+        std::cerr << file << ":" << line << ": check failed: " << expression << '\n';
+        ++failures;
+    }
+
+    inline int finish()
+    {
+        if (failures) std::cerr << failures << " check(s) failed\n";
+        return failures ? 1 : 0;
+    }
+} // namespace check
+
+#define CHECK(expression) check::report(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
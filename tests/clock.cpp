@@ -0,0 +1,171 @@
+// Timers driven by Timed::tsc_clock.
+#include "timer.hpp"
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+
+static long long spin(int n)
+{
+    long long total = 0;
+    for (int i = 0; i < n; ++i) Timed::do_not_optimize(total += i);
+    return total;
+}
+
+// A std Clock in nanoseconds, whatever the tick length.
+static_assert(std::chrono::is_clock_v<Timed::tsc_clock>);
+static_assert(std::same_as<Timed::tsc_clock::duration, std::chrono::nanoseconds>);
+static_assert(std::same_as<Timed::tsc_clock::time_point::clock, Timed::tsc_clock>);
+
+struct CaptureSink : Timed::Sink
+{
+    Timed::Record record;
+    void write(const Timed::Record& written) noexcept override { record = written; }
+};
+
+static bool near(double value, double expected, double tolerance = 0.05)
+{
+    return std::abs(value - expected) <= tolerance * expected;
+}
+
+
+int main()
+{
+    Timed::tsc_clock::calibrate();
+
+    {
+        // the same interval measured by both clocks
+        const auto steady_start = std::chrono::steady_clock::now();
+        const auto tsc_start = Timed::tsc_clock::now();
+        do {} while (std::chrono::steady_clock::now() - steady_start < 20ms);
+        const auto tsc_end = Timed::tsc_clock::now();
+        const auto steady_end = std::chrono::steady_clock::now();
+
+        const double steady = std::chrono::duration<double, std::nano>(steady_end - steady_start).count();
+        CHECK(near(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tsc_end - tsc_start).count()), steady));
+        CHECK(near(std::chrono::duration<double, std::milli>(tsc_end - tsc_start).count(), steady / 1e6));
+        CHECK(near(static_cast<double>(Timed::detail::to_nanoseconds<Timed::tsc_clock>(tsc_end - tsc_start)), steady));
+        CHECK(tsc_start < tsc_end);
+        CHECK(tsc_start + (tsc_end - tsc_start) == tsc_end);
+
+        // raw counter values land on the same time line
+        const auto from_ticks = Timed::tsc_clock::from_ticks(Timed::tsc_clock::ticks());
+        const auto now = Timed::tsc_clock::now().time_since_epoch();
+        CHECK(from_ticks <= now && now - from_ticks < 1ms);
+    }
+
+    {
+        // timers report nanoseconds to their histogram, registry and sink
+        Timed::Histogram histogram;
+        CaptureSink sink;
+        Timed::detail::BaseTimerSettings settings { "tsc" };
+        settings.histogram = &histogram;
+        settings.record = true;
+        settings.sink = &sink;
+
+        int64_t elapsed = 0;
+        const auto steady_start = std::chrono::steady_clock::now();
+        {
+            Timed::FunctionTimer<void, Timed::automatic_duration, Timed::tsc_clock> timer(settings, [] {
+                std::this_thread::sleep_for(10ms);
+            });
+            elapsed = timer.get_elapsed();
+        }
+        const double steady = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - steady_start).count();
+
+        CHECK(elapsed >= 10'000'000);
+        CHECK(static_cast<double>(elapsed) <= steady);
+        CHECK(histogram.snapshot().get_max() == elapsed);
+        CHECK(std::abs(sink.record.get_elapsed() - elapsed) <= 1); // start and end are rounded apart
+        bool recorded = false;
+        for (const auto& summary : Timed::Registry::snapshot())
+            recorded |= summary.name == "tsc" && summary.max == elapsed;
+        CHECK(recorded);
+    }
+
+    {
+        std::ostringstream out;
+        Timed::detail::BaseTimerSettings settings { "block", Timed::Format("{result}"), true, std::source_location::current(), out };
+        {
+            Timed::BlockTimer<std::chrono::milliseconds, Timed::tsc_clock> timer(settings);
+            std::this_thread::sleep_for(20ms);
+            timer.end_and_show_result();
+        }
+        const int reported = std::stoi(out.str());
+        CHECK(reported >= 20 && reported < 1000);
+    }
+
+    {
+        using TscBenchmark = Timed::Benchmark<Timed::automatic_duration, Timed::tsc_clock>;
+        using SteadyBenchmark = Timed::Benchmark<Timed::automatic_duration, std::chrono::steady_clock>;
+        TscBenchmark::Settings settings { { "benchmark" } };
+        settings.show_output = false;
+        settings.warmup = 1ms;
+        TscBenchmark benchmark(settings, spin, 1000);
+        SteadyBenchmark reference({ settings, settings.samples, settings.warmup }, spin, 1000);
+        CHECK(near(benchmark.get_median_time(), reference.get_median_time(), 0.3));
+        CHECK(benchmark.get_clock_resolution() < 1000);
+    }
+
+    {
+        Timed::ThreadedFunctionTimer<Timed::automatic_duration, Timed::tsc_clock>::Settings settings { { "threads" }, 2, 200 };
+        settings.show_output = false;
+        Timed::ThreadedFunctionTimer<Timed::automatic_duration, Timed::tsc_clock> timer(settings, spin, 10000);
+        CHECK(timer.get_latency().get_count() == 400);
+        CHECK(timer.get_latency().get_percentile(0.5) > 100);
+        CHECK(timer.get_latency().get_percentile(0.5) < 100'000'000);
+    }
+
+    {
+        Timed::Sweep<Timed::automatic_duration, Timed::tsc_clock> sweep({ { "sweep", Timed::Format(""), false }, { 1000, 100000 }, 5 }, spin);
+        CHECK(sweep.get_points().size() == 2);
+        CHECK(sweep.get_points()[1].second > sweep.get_points()[0].second);
+    }
+
+    {
+        Timed::TaskTimer<Timed::automatic_duration, Timed::tsc_clock> timer({ "task", Timed::Format(""), false });
+        std::this_thread::sleep_for(5ms);
+        timer.end();
+        CHECK(timer.get_active_time() >= 5'000'000);
+        CHECK(timer.get_active_time() < 1'000'000'000);
+    }
+
+    using TscAverage = Timed::AverageFunctionTimer<Timed::automatic_duration, Timed::tsc_clock>;
+
+    {
+        // an unreachable precision: only the time budget ends the adaptive mode
+        TscAverage::Settings settings { { "budget" } };
+        settings.show_output = false;
+        settings.iterations = 2;
+        settings.target_precision = 1e-9;
+        settings.time_budget = 50ms;
+
+        const auto wall_start = std::chrono::steady_clock::now();
+        TscAverage timer(settings, [i = 0]() mutable { return spin(++i % 2 ? 1000 : 20000); });
+        const auto wall = std::chrono::steady_clock::now() - wall_start;
+
+        CHECK(wall >= 50ms);
+        CHECK(wall < 1s);
+        CHECK(timer.get_iterations() > 100);
+        CHECK(timer.get_total_time() > 25'000'000);
+    }
+
+    {
+        // a reachable precision ends it well before the budget
+        TscAverage::Settings settings { { "precision" } };
+        settings.show_output = false;
+        settings.iterations = 5;
+        settings.target_precision = 0.01;
+        settings.time_budget = 5s;
+
+        const auto wall_start = std::chrono::steady_clock::now();
+        TscAverage timer(settings, spin, 5000);
+        const auto wall = std::chrono::steady_clock::now() - wall_start;
+
+        CHECK(timer.get_iterations() >= 5);
+        CHECK(timer.get_relative_error() <= 0.01);
+        CHECK(wall < 5s);
+    }
+
+    return check::finish();
+}
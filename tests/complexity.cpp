@@ -0,0 +1,79 @@
+// Big-O fitting of (n, time) points, geometric ranges and Sweep.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+static std::vector<std::pair<int64_t, int64_t>> points(double (*model)(double))
+{
+    std::vector<std::pair<int64_t, int64_t>> result;
+    for (int64_t n : Timed::geometric_range(16, 1 << 16, 2))
+        result.emplace_back(n, static_cast<int64_t>(model(static_cast<double>(n))));
+    return result;
+}
+
+
+int main()
+{
+    using Timed::Complexity;
+
+    CHECK((Timed::geometric_range(8, 100, 4) == std::vector<int64_t> { 8, 32, 100 }));
+    CHECK((Timed::geometric_range(1, 8) == std::vector<int64_t> { 1, 2, 4, 8 }));
+    CHECK((Timed::geometric_range(0, 1, 1) == std::vector<int64_t> { 1 }));
+
+    {
+        auto fit = Timed::detail::best_complexity_fit(points([](double) { return 500.0; }));
+        CHECK(fit.complexity == Complexity::constant);
+        CHECK(fit.coefficient == 500);
+        CHECK(fit.rms == 0);
+    }
+    {
+        auto fit = Timed::detail::best_complexity_fit(points([](double n) { return 7 * std::log2(n) * 100; }));
+        CHECK(fit.complexity == Complexity::log_n);
+        CHECK(std::abs(fit.coefficient - 700) < 1);
+    }
+    {
+        auto fit = Timed::detail::best_complexity_fit(points([](double n) { return 3 * n; }));
+        CHECK(fit.complexity == Complexity::n);
+        CHECK(std::abs(fit.coefficient - 3) < 1e-9);
+        CHECK(fit.rms < 1e-9);
+    }
+    {
+        auto fit = Timed::detail::best_complexity_fit(points([](double n) { return 2 * n * std::log2(n); }));
+        CHECK(fit.complexity == Complexity::n_log_n);
+        CHECK(std::abs(fit.coefficient - 2) < 1e-3);
+    }
+    {
+        auto fit = Timed::detail::best_complexity_fit(points([](double n) { return n * n / 4; }));
+        CHECK(fit.complexity == Complexity::n_squared);
+        CHECK(std::abs(fit.coefficient - 0.25) < 1e-6);
+    }
+    {
+        // a linear fit of quadratic data is visibly off
+        auto fit = Timed::detail::fit_complexity(Complexity::n, points([](double n) { return n * n; }));
+        CHECK(fit.rms > 0.5);
+    }
+
+    {
+        // the points are never merged into one destination
+        Timed::Histogram histogram;
+        Timed::Baseline baseline;
+        Timed::Sweep<>::Settings settings { { "sweep mixed" }, { 1, 10, 100 }, 3 };
+        settings.show_output = false;
+        settings.record = true;
+        settings.histogram = &histogram;
+        settings.baseline = &baseline;
+        Timed::Sweep sweep(settings, [](int64_t n) { return n * n; });
+
+        CHECK(sweep.get_points().size() == 3);
+        CHECK(histogram.snapshot().get_count() == 0);
+        CHECK(baseline.get_names().empty());
+        bool recorded = false;
+        for (const auto& summary : Timed::Registry::snapshot()) recorded |= summary.name == "sweep mixed";
+        CHECK(!recorded);
+    }
+
+    CHECK(Timed::to_string(Complexity::n_log_n) == "O(n log n)");
+    CHECK(Complexity::log_n <= Complexity::n);
+
+    return check::finish();
+}
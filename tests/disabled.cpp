@@ -0,0 +1,73 @@
+// With TIMED_DISABLE every timer still calls its function but measures and emits nothing.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <sstream>
+
+static_assert(!TIMED_ENABLED, "this test is built with -DTIMED_DISABLE");
+
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    std::ostringstream out;
+    Timed::Histogram histogram;
+    Timed::Baseline baseline;
+    Timed::detail::BaseTimerSettings base { "disabled", Timed::Format("{name} {result}"), true, std::source_location::current(), out };
+    base.record = true;
+    base.histogram = &histogram;
+    base.baseline = &baseline;
+
+    int calls = 0;
+    auto call = [&] { return ++calls; };
+
+    {
+        Timed::FunctionTimer timer(base, call);
+        CHECK(timer.get_result() == 1);
+        CHECK(timer.get_elapsed() == 0);
+        CHECK(!timer.is_sampled());
+    }
+    {
+        Timed::BlockTimer timer(base);
+        timer.end_and_show_result();
+        CHECK(timer.get_elapsed() == 0);
+    }
+    { Timed::ProfileTimer scope(base); }
+    {
+        Timed::TaskTimer timer(base);
+        timer.end();
+        CHECK(timer.get_total_time() == 0);
+    }
+    {
+        // the repeated timers call the function once
+        Timed::AverageFunctionTimer<>::Settings settings { base, 100 };
+        Timed::AverageFunctionTimer<> timer(settings, call);
+        CHECK(timer.get_iterations() == 0);
+    }
+    { Timed::Benchmark<> benchmark({ base }, call); }
+    { Timed::ThreadedFunctionTimer<> timer({ base, 4, 100 }, call); }
+    { Timed::CacheBenchmark<> benchmark({ base, 10, {} }, call); }
+    { Timed::Comparison<> comparison({ base, 10 }, call, call); }
+    {
+        Timed::Sweep<> sweep({ base, { 1, 2, 3 } }, [&](int64_t) { ++calls; });
+        CHECK(sweep.get_points().empty());
+    }
+    CHECK(calls == 1 + 1 + 1 + 1 + 1 + 2 + 3);
+
+    {
+        Timed::Reporter<>::Settings settings { base, 1ms, Timed::Reporter<>::Style::table, {} };
+        Timed::Reporter<> reporter(settings);
+        reporter.report();
+        CHECK(reporter.get_reports() == 0);
+    }
+
+    // nothing was printed, recorded or traced
+    CHECK(out.str().empty());
+    CHECK(histogram.snapshot().get_count() == 0);
+    CHECK(baseline.get_names().empty());
+    CHECK(Timed::Registry::snapshot().empty());
+    CHECK(Timed::Profiler::snapshot().children.empty());
+
+    return check::finish();
+}
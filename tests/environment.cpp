@@ -0,0 +1,84 @@
+// Environment pinning, priority, warnings and machine description.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <sstream>
+
+
+int main()
+{
+    {
+        const auto metadata = Timed::Environment::detect();
+        CHECK(metadata.cpus == std::thread::hardware_concurrency());
+        CHECK(metadata.cpu == -1);
+        CHECK(!metadata.cpu_model.empty());
+        CHECK(metadata.warnings.empty());
+
+        const auto entries = metadata.entries();
+        CHECK(entries.size() == 9);
+        CHECK(entries.front().first == "cpu_model");
+
+        std::ostringstream json;
+        metadata.write_json(json);
+        CHECK(json.str().starts_with("{\"cpu_model\":\""));
+        CHECK(json.str().ends_with(",\"warnings\":[]}"));
+    }
+
+    {
+        // warnings go to the stream when asked, and always into the metadata
+        std::ostringstream shown, hidden;
+        Timed::Environment loud({ 1 << 20, false, true, shown });
+        Timed::Environment quiet({ 1 << 20, false, false, hidden });
+        CHECK(hidden.str().empty());
+        CHECK(loud.get_metadata().warnings.size() == quiet.get_metadata().warnings.size());
+        CHECK(!quiet.get_metadata().warnings.empty());
+        CHECK(shown.str().find("Timed: warning: ") == 0);
+        for (const auto& warning : quiet.get_metadata().warnings) CHECK(shown.str().find(warning) != std::string::npos);
+        CHECK(quiet.pinned_cpu() == -1);
+
+        std::ostringstream json;
+        quiet.get_metadata().write_json(json);
+        CHECK(json.str().find(",\"warnings\":[\"") != std::string::npos);
+    }
+
+#if TIMED_HAS_AFFINITY
+    {
+        // pinning moves the thread to the CPU and restores the previous affinity afterwards
+        cpu_set_t before;
+        CHECK(pthread_getaffinity_np(pthread_self(), sizeof(before), &before) == 0);
+        const int cpu = sched_getcpu();
+        {
+            std::ostringstream warnings;
+            Timed::Environment environment({ cpu, false, true, warnings });
+            CHECK(environment.pinned_cpu() == cpu);
+            CHECK(environment.get_metadata().cpu == cpu);
+            CHECK(sched_getcpu() == cpu);
+            cpu_set_t during;
+            pthread_getaffinity_np(pthread_self(), sizeof(during), &during);
+            CHECK(CPU_COUNT(&during) == 1 && CPU_ISSET(cpu, &during));
+            CHECK(warnings.str().find("could not pin") == std::string::npos);
+        }
+        cpu_set_t after;
+        pthread_getaffinity_np(pthread_self(), sizeof(after), &after);
+        CHECK(CPU_EQUAL(&before, &after));
+    }
+
+    {
+        // the priority is raised where permitted, otherwise that is a warning; restored either way
+        const auto thread = static_cast<id_t>(syscall(SYS_gettid));
+        const int before = getpriority(PRIO_PROCESS, thread);
+        {
+            std::ostringstream warnings;
+            Timed::Environment environment({ -1, true, true, warnings });
+            if (environment.get_metadata().priority_raised) {
+                CHECK(getpriority(PRIO_PROCESS, thread) == -20);
+            } else {
+                CHECK(warnings.str().find("could not raise the thread priority") != std::string::npos);
+            }
+        }
+        CHECK(getpriority(PRIO_PROCESS, thread) == before);
+    }
+#endif
+
+    return check::finish();
+}
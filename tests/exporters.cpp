@@ -0,0 +1,92 @@
+// StatsD datagrams and the Prometheus text exposition of registry summaries.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+// Loopback UDP socket standing in for the StatsD daemon.
+class Receiver
+{
+private:
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    std::uint16_t port = 0;
+
+public:
+    Receiver()
+    {
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size = sizeof(address);
+        if (bind(fd, reinterpret_cast<const sockaddr*>(&address), size) != 0) return;
+        if (getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) == 0) port = ntohs(address.sin_port);
+    }
+    ~Receiver() { close(fd); }
+
+    [[nodiscard]] std::uint16_t get_port() const noexcept { return port; }
+
+    // Every datagram received within the timeout, joined with newlines.
+    std::string receive()
+    {
+        std::string lines;
+        pollfd wait { fd, POLLIN, 0 };
+        while (poll(&wait, 1, 200) > 0) {
+            char buffer[2048];
+            auto size = recv(fd, buffer, sizeof(buffer), 0);
+            if (size <= 0) break;
+            if (!lines.empty()) lines.push_back('\n');
+            lines.append(buffer, static_cast<std::size_t>(size));
+        }
+        return lines;
+    }
+};
+
+
+int main()
+{
+    const auto here = std::source_location::current();
+
+    {
+        Receiver receiver;
+        CHECK(receiver.get_port() != 0);
+        Timed::StatsdExporter exporter({ "127.0.0.1", receiver.get_port(), std::chrono::hours(1), "test" });
+        CHECK(exporter.is_open());
+
+        for (int i = 0; i < 10; ++i) Timed::Registry::record("statsd site", here, 2'000'000);
+        exporter.flush();
+        std::string lines = receiver.receive();
+        CHECK(lines.find("test.statsd_site.count:10|c") != std::string::npos);
+        CHECK(lines.find("test.statsd_site.avg:2.000000|g") != std::string::npos);
+
+        // only the delta of cumulative counters
+        for (int i = 0; i < 4; ++i) Timed::Registry::record("statsd site", here, 2'000'000);
+        exporter.flush();
+        CHECK(receiver.receive().find("test.statsd_site.count:4|c") != std::string::npos);
+
+        // a reset by Registry::collect() sends the current counts, not a wrapped difference
+        (void)Timed::Registry::collect();
+        for (int i = 0; i < 3; ++i) Timed::Registry::record("statsd site", here, 1'000'000);
+        exporter.flush();
+        lines = receiver.receive();
+        CHECK(lines.find("test.statsd_site.count:3|c") != std::string::npos);
+        CHECK(lines.find("test.statsd_site.avg:1.000000|g") != std::string::npos);
+
+        exporter.flush();
+        CHECK(receiver.receive().empty());
+    }
+
+    {
+        Timed::Registry::Summary summary { "latency \"x\"", here, 3, 30, 5, 15 };
+        summary.buckets[3] = 1;  // below 8 ns
+        summary.buckets[4] = 2;  // below 16 ns
+        std::ostringstream out;
+        Timed::write_prometheus(out, { summary }, "app");
+        const std::string text = out.str();
+        CHECK(text.find("# TYPE app_duration_seconds histogram") != std::string::npos);
+        CHECK(text.find("name=\"latency \\\"x\\\"\"") != std::string::npos);
+        CHECK(text.find("app_duration_seconds_count{") != std::string::npos);
+        CHECK(text.find("le=\"1.6e-08\"} 3") != std::string::npos);
+        CHECK(text.find("le=\"+Inf\"} 3") != std::string::npos);
+    }
+
+    return check::finish();
+}
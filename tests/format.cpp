@@ -0,0 +1,134 @@
+// Format parsing into segments and single-pass rendering.
+#include "timer.hpp"
+#include "check.hpp"
+
+using namespace Timed::literals;
+using Field = Timed::Format::Field;
+
+
+static std::string render(const Timed::Format& format, const Timed::Format::Fields& fields)
+{
+    std::string out;
+    format.render(std::back_inserter(out), fields);
+    return out;
+}
+
+// `count` times "{row}-", as a constant: two segments each.
+template <std::size_t count>
+struct Repeated
+{
+    char text[count * 6 + 1] {};
+
+    constexpr Repeated()
+    {
+        for (std::size_t i = 0; i < count * 6; ++i) text[i] = "{row}-"[i % 6];
+    }
+    constexpr std::string_view view() const { return { text, count * 6 }; }
+};
+
+template <std::size_t count>
+inline constexpr Repeated<count> repeated {};
+
+// Whether the format of `count` placeholders parses in a constant expression.
+template <std::size_t count>
+concept ParsesAtCompileTime = requires {
+    typename std::integral_constant<std::size_t, Timed::Format(repeated<count>.view()).size()>;
+};
+
+static_assert(Timed::Format::max_segments == 24);
+static_assert(ParsesAtCompileTime<12>);
+static_assert(!ParsesAtCompileTime<13>, "a literal format beyond max_segments must not compile");
+
+
+int main()
+{
+    const Timed::Format::Fields fields { "main.cpp", 42, "foo", "int main()", "12 ns" };
+
+    {
+        Timed::Format format("[{filename}:{row}] {name} -> {result}");
+        CHECK(format.size() == 8);
+        CHECK(format[0].field == Field::literal);
+        CHECK(format[1].field == Field::filename);
+        CHECK(format[3].field == Field::row);
+        CHECK(format[7].field == Field::result);
+        CHECK(render(format, fields) == "[main.cpp:42] foo -> 12 ns");
+    }
+
+    {
+        // unknown placeholders and unbalanced braces stay literal text, merged into one segment
+        Timed::Format format("{unknown} {name} {oops");
+        CHECK(format.size() == 3);
+        CHECK(format[0].field == Field::literal);
+        CHECK(format[1].field == Field::name);
+        CHECK(format[2].field == Field::literal);
+        CHECK(render(format, fields) == "{unknown} foo {oops");
+    }
+
+    {
+        // parsed at compile time
+        constexpr Timed::Format format = "{function}: {result}"_fmt;
+        static_assert(format.size() == 3);
+        static_assert(format[0].field == Field::function);
+        CHECK(render(format, fields) == "int main(): 12 ns");
+    }
+
+    {
+        Timed::Format format("{cycles} {ipc} {allocations} {throughput} {ns_per_item}");
+        CHECK(render(format, fields) == "n/a n/a n/a n/a n/a");
+
+        Timed::Counters counters { 2000, 3000 };
+        Timed::Allocations allocations { 3, 96, 64 };
+        Timed::Work work { 4'000'000, 1000, 1000 };
+        Timed::Format::Fields measured = fields;
+        measured.counters = &counters;
+        measured.allocations = &allocations;
+        measured.work = &work;
+        CHECK(render(format, measured) == "2000 1.50 3 4.000 TB/s 1.000 ns");
+    }
+
+    {
+        // a runtime format owns its text: built from a temporary, it outlives it
+        Timed::Format format = Timed::Format(std::string(40, '-') + " {name}");
+        Timed::detail::BaseTimerSettings settings { "runtime" };
+        {
+            std::string text = "{name} took {result}";
+            settings.format = text;
+            text.assign(text.size(), '#');
+        }
+        CHECK(!format.is_literal());
+        CHECK(render(format, fields) == std::string(40, '-') + " foo");
+        CHECK(settings.get_format() == "{name} took {result}");
+        CHECK(render(settings.format, fields) == "foo took 12 ns");
+
+        // copies share the text, and the last one frees it
+        Timed::Format copy = format;
+        CHECK(copy.str().data() == format.str().data());
+        format = Timed::Format("{row}");
+        CHECK(render(copy, fields) == std::string(40, '-') + " foo");
+        CHECK(render(format, fields) == "42");
+        Timed::Format moved = std::move(copy);
+        CHECK(render(moved, fields) == std::string(40, '-') + " foo");
+    }
+
+    {
+        // literal formats are views, parsed at compile time
+        constexpr Timed::Format format("{name}");
+        static_assert(format.is_literal());
+        CHECK(format.str() == "{name}");
+        CHECK(Timed::detail::BaseTimerSettings::default_format.is_literal());
+    }
+
+    {
+        // runtime formats are not limited to max_segments
+        Timed::Format format(repeated<40>.view());
+        CHECK(format.size() == 80);
+        std::string expected;
+        for (int i = 0; i < 40; ++i) expected += "42-";
+        CHECK(render(format, fields) == expected);
+    }
+
+    CHECK(render(Timed::Format(""), fields).empty());
+    CHECK(Timed::Format("plain").size() == 1);
+
+    return check::finish();
+}
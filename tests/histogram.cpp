@@ -0,0 +1,82 @@
+// Histogram bucketing, percentiles, merging and collect/reset.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+int main()
+{
+    using Buckets = Timed::Histogram::Buckets;
+
+    {
+        bool consistent = true;
+        for (std::size_t i = 0; i < Buckets::count; ++i) {
+            consistent &= Buckets::index(Buckets::lower_bound(i)) == i;
+            consistent &= Buckets::index(Buckets::upper_bound(i)) == i;
+        }
+        CHECK(consistent);
+        CHECK(Buckets::index(-5) == 0);
+        CHECK(Buckets::index(std::numeric_limits<int64_t>::max()) == Buckets::count - 1);
+
+        // the midpoint of every bucket is within 1% of its values
+        bool precise = true;
+        for (std::size_t i = Buckets::sub_bucket_count; i + 1 < Buckets::count; ++i)
+            precise &= static_cast<double>(Buckets::upper_bound(i) - Buckets::lower_bound(i)) / 2 <= 0.01 * static_cast<double>(Buckets::lower_bound(i));
+        CHECK(precise);
+    }
+
+    {
+        // exact below 2^7
+        Timed::Histogram::Snapshot small;
+        for (int64_t value = 1; value <= 100; ++value) small.record(value);
+        CHECK(small.get_count() == 100);
+        CHECK(small.get_total() == 5050);
+        CHECK(small.get_min() == 1);
+        CHECK(small.get_max() == 100);
+        CHECK(small.get_percentile(0) == 1);
+        CHECK(small.get_percentile(0.5) == 50);
+        CHECK(small.get_percentile(0.99) == 99);
+        CHECK(small.get_percentile(1) == 100);
+    }
+
+    {
+        Timed::Histogram histogram;
+        for (int64_t value = 1; value <= 100000; ++value) histogram.record(value * 1000);
+
+        auto within = [](int64_t value, double expected) {
+            return std::abs(static_cast<double>(value) - expected) <= 0.01 * expected;
+        };
+        CHECK(within(histogram.get_percentile(0.5), 50'000'000));
+        CHECK(within(histogram.get_percentile(0.9), 90'000'000));
+        CHECK(within(histogram.get_percentile(0.999), 99'900'000));
+        CHECK(histogram.get_percentile(1) == 100'000'000);
+
+        Timed::Histogram::Snapshot other;
+        other.record(1);
+        histogram.merge(other);
+
+        auto collected = histogram.collect();
+        CHECK(collected.get_count() == 100001);
+        CHECK(collected.get_min() == 1);
+        CHECK(collected.get_max() == 100'000'000);
+
+        // the window starts over
+        auto empty = histogram.snapshot();
+        CHECK(empty.get_count() == 0);
+        CHECK(empty.get_percentile(0.5) == 0);
+        histogram.record(7);
+        CHECK(histogram.snapshot().get_min() == 7);
+        CHECK(histogram.snapshot().get_max() == 7);
+    }
+
+    {
+        // concurrent recorders are never lost
+        Timed::Histogram histogram;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&] { for (int i = 0; i < 10000; ++i) histogram.record(i); });
+        for (auto& thread : threads) thread.join();
+        CHECK(histogram.snapshot().get_count() == 40000);
+    }
+
+    return check::finish();
+}
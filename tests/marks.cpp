@@ -0,0 +1,99 @@
+// Timed::mark rings and the intervals rebuilt by Marks::collect.
+#define TIMED_MARK_CAPACITY 64
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <thread>
+
+
+static constexpr Timed::MarkSite begin { "begin" };
+static constexpr Timed::MarkSite end { "end" };
+static constexpr Timed::MarkSite tick { "tick" };
+
+
+// Each thread's intervals come out contiguously, oldest first, alternating begin/end.
+static bool alternates(const std::vector<Timed::MarkInterval>& intervals, std::size_t first, std::size_t count)
+{
+    bool ordered = true;
+    for (std::size_t i = first; i < first + count; ++i) {
+        const bool forward = (i - first) % 2 == 0;
+        ordered &= intervals[i].from == (forward ? &begin : &end) && intervals[i].to == (forward ? &end : &begin);
+        if (i > first) ordered &= intervals[i].start >= intervals[i - 1].start + intervals[i - 1].duration - 1;
+    }
+    return ordered;
+}
+
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    {
+        Timed::mark(begin);
+        std::this_thread::sleep_for(2ms);
+        Timed::mark(end);
+        Timed::mark(begin);
+        Timed::mark(end);
+        auto intervals = Timed::Marks::collect(false);
+        CHECK(intervals.size() == 3);
+        if (intervals.size() == 3) {
+            CHECK(alternates(intervals, 0, 3));
+            CHECK(intervals[0].duration >= 2'000'000);
+            CHECK(intervals[0].duration < 1'000'000'000);
+        }
+        // collecting empties the rings
+        CHECK(Timed::Marks::collect(false).empty());
+    }
+
+    {
+        // marks of several threads: no interval spans two threads, each thread stays in order
+        constexpr int threads = 3, pairs = 10;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+            workers.emplace_back([] {
+                for (int i = 0; i < pairs; ++i) {
+                    Timed::mark(begin);
+                    Timed::mark(end);
+                }
+            });
+        for (auto& worker : workers) worker.join();
+
+        auto intervals = Timed::Marks::collect(false);
+        CHECK(intervals.size() == threads * (2 * pairs - 1));
+        if (intervals.size() == threads * (2 * pairs - 1))
+            for (int t = 0; t < threads; ++t) CHECK(alternates(intervals, t * (2 * pairs - 1), 2 * pairs - 1));
+    }
+
+    {
+        // intervals are recorded as "from -> to" sites, or the site name for a repeated mark
+        Timed::mark(tick);
+        Timed::mark(tick);
+        Timed::mark(begin);
+        Timed::mark(end);
+        CHECK(Timed::Marks::collect().size() == 3);
+        auto summaries = Timed::Registry::snapshot();
+        auto count = [&](std::string_view name) {
+            for (const auto& summary : summaries)
+                if (summary.name == name) return summary.count;
+            return std::uint64_t(0);
+        };
+        CHECK(count("tick") == 1);
+        CHECK(count("tick -> begin") == 1);
+        CHECK(count("begin -> end") == 1);
+    }
+
+    {
+        // a wrapped ring keeps the newest TIMED_MARK_CAPACITY marks and counts the others
+        for (int i = 0; i < 50; ++i) {
+            Timed::mark(begin);
+            Timed::mark(end);
+        }
+        CHECK(Timed::Marks::get_overwritten() == 100 - 64);
+        auto intervals = Timed::Marks::collect(false);
+        CHECK(intervals.size() == 63);
+        if (intervals.size() == 63) CHECK(alternates(intervals, 0, 63));
+        CHECK(Timed::Marks::get_overwritten() == 0);
+    }
+
+    return check::finish();
+}
@@ -0,0 +1,73 @@
+// Profiler call trees built by nested ProfileTimer scopes, merged across threads.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <thread>
+
+
+static Timed::detail::BaseTimerSettings quiet(std::string_view name, std::source_location location = std::source_location::current())
+{
+    return { name, Timed::Format(""), false, location };
+}
+
+static void inner()
+{
+    Timed::ProfileTimer scope(quiet("inner"));
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+static void outer()
+{
+    Timed::ProfileTimer scope(quiet("outer"));
+    inner();
+    inner();
+}
+
+static const Timed::Profiler::Node* child(const Timed::Profiler::Node& node, std::string_view name)
+{
+    for (const auto& found : node.children)
+        if (found.name == name) return &found;
+    return nullptr;
+}
+
+
+int main()
+{
+    for (int i = 0; i < 5; ++i) outer();
+    std::thread other([] { for (int i = 0; i < 5; ++i) outer(); });
+    other.join();
+    // the same scope outside `outer` is another call path
+    inner();
+
+    const Timed::Profiler::Node root = Timed::Profiler::snapshot();
+    CHECK(root.children.size() == 2);
+    const auto* outer_node = child(root, "outer");
+    const auto* top_inner = child(root, "inner");
+    CHECK(outer_node && top_inner);
+    if (outer_node && top_inner) {
+        // both threads' trees merged into one path
+        CHECK(outer_node->calls == 10);
+        CHECK(outer_node->children.size() == 1);
+        const auto* nested = child(*outer_node, "inner");
+        CHECK(nested && nested->calls == 20);
+        CHECK(top_inner->calls == 1);
+        if (nested) {
+            CHECK(nested->inclusive >= 20 * 200'000);
+            CHECK(nested->inclusive <= outer_node->inclusive);
+            CHECK(outer_node->self == outer_node->inclusive - nested->inclusive);
+            CHECK(nested->self == nested->inclusive);
+        }
+        CHECK(root.inclusive == outer_node->inclusive + top_inner->inclusive);
+    }
+
+    std::ostringstream report;
+    Timed::Profiler::report(report);
+    const std::string text = report.str();
+    CHECK(text.find("outer [") == 0);
+    CHECK(text.find("\n  inner [") != std::string::npos);
+    CHECK(text.find("calls: 20") != std::string::npos);
+    CHECK(text.find("\ninner [") != std::string::npos);
+
+    return check::finish();
+}
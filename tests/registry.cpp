@@ -0,0 +1,106 @@
+// Registry aggregation per site, snapshot() and the resetting collect(), and sampled timers.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+static const Timed::Registry::Summary* find(const std::vector<Timed::Registry::Summary>& summaries, std::string_view name)
+{
+    for (const auto& summary : summaries)
+        if (summary.name == name) return &summary;
+    return nullptr;
+}
+
+
+int main()
+{
+    const auto here = std::source_location::current();
+
+    for (int64_t value = 1; value <= 100; ++value) Timed::Registry::record("values", here, value);
+    // same name and location through another string: the same site
+    std::string name = "values";
+    Timed::Registry::record(name, here, 1000);
+    Timed::Registry::record("other", here, 5);
+
+    {
+        auto summaries = Timed::Registry::snapshot();
+        const auto* values = find(summaries, "values");
+        CHECK(values != nullptr);
+        if (values) {
+            CHECK(values->count == 101);
+            CHECK(values->sum == 6050);
+            CHECK(values->min == 1);
+            CHECK(values->max == 1000);
+            CHECK(values->get_average() == 59);
+            CHECK(values->buckets[1] == 1);  // 1
+            CHECK(values->buckets[7] == 37); // 64 ... 100
+            CHECK(values->buckets[10] == 1); // 1000
+            CHECK(values->get_percentile(0.5) == 63);
+            CHECK(values->get_percentile(1) == 1000);
+        }
+        CHECK(find(summaries, "other") && find(summaries, "other")->count == 1);
+    }
+
+    {
+        // snapshot() does not reset
+        auto again = Timed::Registry::snapshot();
+        CHECK(find(again, "values") && find(again, "values")->count == 101);
+
+        auto collected = Timed::Registry::collect();
+        CHECK(find(collected, "values") && find(collected, "values")->count == 101);
+
+        auto empty = Timed::Registry::collect();
+        const auto* values = find(empty, "values");
+        CHECK(values && values->count == 0 && values->sum == 0 && values->get_percentile(0.5) == 0);
+    }
+
+    {
+        // concurrent recorders land in the next window, none lost
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&] { for (int i = 0; i < 25000; ++i) Timed::Registry::record("threads", here, 10); });
+        std::uint64_t total = 0;
+        auto add = [&] {
+            auto window = Timed::Registry::collect();
+            if (const auto* summary = find(window, "threads")) total += summary->count;
+        };
+        for (int i = 0; i < 100; ++i) add();
+        for (auto& thread : threads) thread.join();
+        add();
+        CHECK(total == 100000);
+    }
+
+    {
+        // timers feed the registry through `record`
+        Timed::detail::BaseTimerSettings settings { "timed" };
+        settings.show_output = false;
+        settings.record = true;
+        {
+            Timed::FunctionTimer timer(settings, [] { return 1; });
+            CHECK(find(Timed::Registry::snapshot(), "timed") == nullptr);
+        }
+        auto summaries = Timed::Registry::snapshot();
+        CHECK(find(summaries, "timed") && find(summaries, "timed")->count == 1);
+    }
+
+    {
+        // sample_every = N times 1 in N calls of each site, even when two sites interleave
+        Timed::detail::BaseTimerSettings every_10 { "every 10", Timed::Format(""), false, std::source_location::current() };
+        Timed::detail::BaseTimerSettings every_3 { "every 3", Timed::Format(""), false, std::source_location::current() };
+        every_10.record = every_3.record = true;
+        every_10.sample_every = 10;
+        every_3.sample_every = 3;
+        int calls = 0, sampled = 0;
+        for (int i = 0; i < 1000; ++i) {
+            Timed::FunctionTimer ten(every_10, [&] { ++calls; });
+            Timed::FunctionTimer three(every_3, [&] { ++calls; });
+            sampled += ten.is_sampled();
+        }
+        CHECK(calls == 2000); // skipped calls still run
+        CHECK(sampled == 100);
+        auto summaries = Timed::Registry::snapshot();
+        CHECK(find(summaries, "every 10") && find(summaries, "every 10")->count == 100);
+        CHECK(find(summaries, "every 3") && find(summaries, "every 3")->count == 334);
+    }
+
+    return check::finish();
+}
@@ -0,0 +1,90 @@
+// Reporter windows, table rows and JSON lines.
+#include "timer.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <thread>
+
+
+static std::size_t occurrences(const std::string& text, std::string_view part)
+{
+    std::size_t count = 0;
+    for (auto at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) ++count;
+    return count;
+}
+
+
+int main()
+{
+    using namespace std::chrono_literals;
+    using Reporter = Timed::Reporter<std::chrono::nanoseconds>;
+    const auto here = std::source_location::current();
+
+    {
+        std::ostringstream out;
+        Timed::Histogram histogram;
+        Reporter::Settings settings { { "service", Timed::Format(""), true, here, out }, 1h, Reporter::Style::table,
+                                      { { "latency", &histogram } } };
+        {
+            Reporter reporter(settings);
+            for (int64_t value : { 100, 200, 300 }) Timed::Registry::record("alpha", here, value);
+            histogram.record(1000);
+            reporter.report();
+            CHECK(reporter.get_reports() == 1);
+
+            const std::string table = out.str();
+            CHECK(table.starts_with("[service] interval "));
+            CHECK(table.find("site") != std::string::npos && table.find("p99") != std::string::npos);
+            // one row per active site, with its window count
+            const auto alpha = table.find("\nalpha ");
+            CHECK(alpha != std::string::npos);
+            if (alpha != std::string::npos) {
+                const std::string row = table.substr(alpha + 1, table.find('\n', alpha + 1) - alpha - 1);
+                CHECK(row.find(" 3 ") != std::string::npos);
+                CHECK(row.ends_with("300 ns"));
+            }
+            CHECK(table.find("\nlatency ") != std::string::npos);
+
+            // the window was collected: an idle window prints nothing
+            out.str("");
+            reporter.report();
+            CHECK(reporter.get_reports() == 2);
+            CHECK(out.str().empty());
+            for (const auto& summary : Timed::Registry::snapshot()) CHECK(summary.count == 0);
+
+            Timed::Registry::record("beta", here, 50);
+        }
+        // a last report on destruction
+        CHECK(out.str().find("\nbeta ") != std::string::npos);
+        CHECK(out.str().find("alpha") == std::string::npos);
+    }
+
+    {
+        std::ostringstream out;
+        Reporter::Settings settings { { "json", Timed::Format(""), true, here, out }, 1h, Reporter::Style::json_lines, {} };
+        Reporter reporter(settings);
+        Timed::Registry::record("gamma", here, 10);
+        Timed::Registry::record("gamma", here, 20);
+        Timed::Registry::record("delta \"quoted\"", here, 5);
+        reporter.report();
+        const std::string lines = out.str();
+        CHECK(occurrences(lines, "\n") == 2);
+        CHECK(lines.find("\"name\":\"gamma\"") != std::string::npos);
+        CHECK(lines.find("\"count\":2,") != std::string::npos);
+        CHECK(lines.find("\"max_ns\":20}") != std::string::npos);
+        CHECK(lines.find("\"name\":\"delta \\\"quoted\\\"\"") != std::string::npos);
+        CHECK(lines.find("\"line\":" + std::to_string(here.line())) != std::string::npos);
+    }
+
+    {
+        // the background thread reports every interval
+        std::ostringstream out;
+        Reporter::Settings settings { { "periodic", Timed::Format(""), false, here, out }, 10ms, Reporter::Style::table, {} };
+        Reporter reporter(settings);
+        for (int i = 0; i < 500 && reporter.get_reports() < 3; ++i) std::this_thread::sleep_for(5ms);
+        CHECK(reporter.get_reports() >= 3);
+        CHECK(out.str().empty()); // show_output is off
+    }
+
+    return check::finish();
+}
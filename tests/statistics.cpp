@@ -0,0 +1,118 @@
+// Mann-Whitney U p-values, robust statistics, Baseline comparisons and the Comparison bootstrap.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+int main()
+{
+    {
+        std::vector<int64_t> a, b, c;
+        for (int64_t i = 0; i < 50; ++i) {
+            a.push_back(100 + i);
+            b.push_back(100 + i);
+            c.push_back(200 + i);
+        }
+
+        CHECK(Timed::detail::mann_whitney_p(a, b) > 0.9);
+        CHECK(Timed::detail::mann_whitney_p(a, c) < 1e-10);
+        CHECK(Timed::detail::mann_whitney_p(a, c) == Timed::detail::mann_whitney_p(c, a));
+        CHECK(Timed::detail::mann_whitney_p(a, {}) == 1.0);
+
+        // all ties: no evidence either way
+        std::vector<int64_t> same(20, 5);
+        CHECK(Timed::detail::mann_whitney_p(same, same) == 1.0);
+
+        // the histogram version agrees on well separated samples
+        Timed::Histogram::Snapshot ha, hc;
+        for (auto x : a) ha.record(x);
+        for (auto x : c) hc.record(x);
+        CHECK(Timed::detail::mann_whitney_p(ha, hc) < 1e-10);
+
+        // U = 5 for n = 4, 5: z = (10 - 5 - 0.5) / sqrt(50 / 3) = 1.102, p = 0.270
+        double p = Timed::detail::mann_whitney_p(std::vector<int64_t> { 1, 2, 4, 8 }, std::vector<int64_t> { 3, 5, 6, 7, 9 });
+        CHECK(std::abs(p - 0.270) < 0.001);
+
+        // small values get a bucket each, so both versions rank the same ties the same way
+        Timed::Histogram::Snapshot hx, hy;
+        for (int64_t x : { 1, 2, 2, 4, 8 }) hx.record(x);
+        for (int64_t y : { 2, 3, 5, 6, 7, 9, 9 }) hy.record(y);
+        CHECK(Timed::detail::mann_whitney_p(hx, hy)
+              == Timed::detail::mann_whitney_p(std::vector<int64_t> { 1, 2, 2, 4, 8 }, std::vector<int64_t> { 2, 3, 5, 6, 7, 9, 9 }));
+    }
+
+    {
+        std::vector<int64_t> odd { 5, 1, 3 }, even { 4, 1, 3, 2 };
+        CHECK(Timed::detail::median_of(odd) == 3);
+        CHECK(Timed::detail::median_of(even) == 2.5);
+    }
+
+    {
+        Timed::ExactStatistics statistics;
+        for (int64_t x : { 10, 11, 12, 13, 14, 15, 16, 17, 18, 1000 }) statistics.add(x);
+        CHECK(statistics.percentile(0.5) == 14);
+        CHECK(statistics.mad() == 2.5);
+        CHECK(statistics.trimmed_mean(0.1) == 14.5);
+        CHECK(statistics.outliers().high_severe == 1);
+        CHECK(statistics.outliers().total() == 1);
+    }
+
+    {
+        // B does strictly less work than A; the bootstrap interval brackets the speedup
+        auto work = [](int n) {
+            long long total = 0;
+            for (int i = 0; i < n; ++i) Timed::do_not_optimize(total += i);
+            return total;
+        };
+        Timed::Comparison comparison({ { "a vs b", Timed::Format("{result}"), false }, 40 },
+                                     [&] { return work(200000); }, [&] { return work(20000); });
+        auto [low, high] = comparison.get_confidence_interval();
+        CHECK(comparison.get_samples_a().size() == 40);
+        CHECK(comparison.get_samples_b().size() == 40);
+        CHECK(low <= comparison.get_speedup());
+        CHECK(comparison.get_speedup() <= high);
+        CHECK(comparison.get_speedup() > 2);
+        CHECK(comparison.get_verdict() == Timed::Verdict::faster);
+        CHECK(comparison.get_p_value() < 0.001);
+    }
+
+    {
+        Timed::Baseline before, after;
+        for (int64_t i = 0; i < 200; ++i) {
+            before.record("site", 1000 + i);
+            after.record("site", 2000 + i);
+        }
+        after.record("new site", 5);
+
+        const auto report = after.compare(before);
+        CHECK(report.sites.size() == 2);
+        for (const auto& site : report.sites) CHECK(site.name == "new site" ? site.is_new : site.regressed);
+        CHECK(!before.compare(after).sites.front().regressed); // faster is not a regression
+
+        // a baseline compared with itself has nothing to report, and does not deadlock
+        const auto same = before.compare(before);
+        CHECK(same.sites.size() == 1);
+        CHECK(!same.sites.front().regressed);
+        CHECK(same.sites.front().p_value > 0.9);
+    }
+
+    {
+        // the two sides are never mixed into one destination
+        Timed::Histogram histogram;
+        Timed::Baseline baseline;
+        Timed::Comparison<>::Settings settings { { "mixed" }, 10 };
+        settings.show_output = false;
+        settings.record = true;
+        settings.histogram = &histogram;
+        settings.baseline = &baseline;
+        Timed::Comparison comparison(settings, [] { return 1; }, [] { return 2; });
+
+        CHECK(comparison.get_samples_a().size() == 10);
+        CHECK(histogram.snapshot().get_count() == 0);
+        CHECK(baseline.get_names().empty());
+        bool recorded = false;
+        for (const auto& summary : Timed::Registry::snapshot()) recorded |= summary.name == "mixed";
+        CHECK(!recorded);
+    }
+
+    return check::finish();
+}
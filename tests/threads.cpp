@@ -0,0 +1,60 @@
+// ThreadedFunctionTimer runs and the destinations they feed.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+int main()
+{
+    using Timer = Timed::ThreadedFunctionTimer<>;
+    std::atomic<std::uint64_t> calls { 0 };
+    auto work = [&] { calls.fetch_add(1, std::memory_order_relaxed); };
+
+    {
+        Timed::Histogram histogram;
+        Timed::Baseline baseline;
+        Timer::Settings settings { { "threads" }, 3, 500 };
+        settings.show_output = false;
+        settings.histogram = &histogram;
+        settings.baseline = &baseline;
+        settings.record = true;
+        Timer timer(settings, work);
+
+        CHECK(calls.load() == 1500);
+        CHECK(timer.get_runs().size() == 1);
+        CHECK(timer.get_latency().get_count() == 1500);
+        CHECK(histogram.snapshot().get_count() == 1500);
+        CHECK(histogram.snapshot().get_max() == timer.get_latency().get_max());
+        CHECK(baseline.get("threads").get_count() == 1500);
+        CHECK(baseline.get("threads").get_percentile(0.5) == timer.get_latency().get_percentile(0.5));
+        CHECK(timer.get_throughput() > 0);
+
+        // every call of every thread lands in the Registry too
+        std::uint64_t recorded = 0;
+        int64_t max = 0;
+        for (const auto& summary : Timed::Registry::snapshot()) {
+            if (summary.name != "threads") continue;
+            recorded += summary.count;
+            max = std::max(max, summary.max);
+        }
+        CHECK(recorded == 1500);
+        CHECK(max == timer.get_latency().get_max());
+    }
+
+    {
+        // scaling runs 1, 2 and 4 threads, and every run lands in the histogram
+        Timed::Histogram histogram;
+        Timer::Settings settings { { "scaling" }, 4, 200, false, true };
+        settings.show_output = false;
+        settings.histogram = &histogram;
+        Timer timer(settings, work);
+
+        CHECK(timer.get_runs().size() == 3);
+        CHECK(timer.get_runs()[0].threads == 1);
+        CHECK(timer.get_runs()[2].threads == 4);
+        CHECK(timer.get_runs()[0].efficiency == 1);
+        CHECK(timer.get_latency().get_count() == 800);
+        CHECK(histogram.snapshot().get_count() == (1 + 2 + 4) * 200);
+    }
+
+    return check::finish();
+}
@@ -0,0 +1,110 @@
+// Sinks: TraceSink Chrome Trace JSON, StreamSink and AsyncSink output.
+#include "timer.hpp"
+#include "check.hpp"
+
+
+int main()
+{
+    const auto here = std::source_location::current();
+
+    {
+        Timed::TraceSink sink;
+        sink.write({ "outer \"quoted\"", here, 1000, 5500 });
+        std::thread([&] { sink.write({ "inner\n", here, 2000, 2250 }); }).join();
+
+        std::ostringstream json;
+        sink.write_json(json);
+        const std::string line = std::to_string(here.line());
+        std::ostringstream file, function;
+        Timed::detail::write_escaped(file, here.file_name());
+        Timed::detail::write_escaped(function, here.function_name());
+        const std::string args = ",\"args\":{\"file\":\"" + file.str() + "\",\"line\":" + line + ",\"function\":\"" + function.str() + "\"}}";
+        CHECK(json.str() ==
+              "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+              "{\"name\":\"outer \\\"quoted\\\"\",\"cat\":\"timed\",\"ph\":\"X\",\"ts\":1.000,\"dur\":4.500,\"pid\":1,\"tid\":1" + args + ",\n"
+              "{\"name\":\"inner\\n\",\"cat\":\"timed\",\"ph\":\"X\",\"ts\":2.000,\"dur\":0.250,\"pid\":1,\"tid\":2" + args + "\n"
+              "]}\n");
+        CHECK(sink.get_dropped() == 0);
+    }
+
+    {
+        // full buffers and extra threads drop records rather than block
+        Timed::TraceSink sink({}, { 1, 2 });
+        for (int i = 0; i < 3; ++i) sink.write({ "x", here, i, i + 1 });
+        std::thread([&] { sink.write({ "y", here, 0, 1 }); }).join();
+        CHECK(sink.get_dropped() == 2);
+
+        std::ostringstream json;
+        sink.write_json(json);
+        CHECK(json.str().find("\"y\"") == std::string::npos);
+    }
+
+    {
+        std::ostringstream stream;
+        Timed::detail::write_escaped(stream, std::string_view("a\\b\tc\x01", 6));
+        CHECK(stream.str() == "a\\\\b\\tc\\u0001");
+    }
+
+    {
+        std::ostringstream stream;
+        {
+            Timed::StreamSink sink(stream, Timed::Format("{name}: {result}"));
+            sink.write({ "first", here, 0, 1500 });
+            sink.write({ "second", here, 0, 12 });
+        }
+        CHECK(stream.str() == "first: 1.500000 us\nsecond: 12 ns\n");
+    }
+
+    {
+        // threads alternating between two sinks; every record reaches its own sink
+        std::ostringstream first_stream, second_stream;
+        {
+            Timed::AsyncSink first(first_stream, Timed::Format("{name}"), { 4096, std::chrono::milliseconds(1) });
+            Timed::AsyncSink second(second_stream, Timed::Format("{name}"), { 4096, std::chrono::milliseconds(1) });
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 2; ++t) {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < 1000; ++i) {
+                        first.write({ "a", here, 0, 1 });
+                        second.write({ "b", here, 0, 1 });
+                    }
+                });
+            }
+            for (auto& thread : threads) thread.join();
+            CHECK(first.get_dropped() == 0);
+            CHECK(second.get_dropped() == 0);
+        }
+        CHECK(first_stream.str() == [] { std::string lines; for (int i = 0; i < 2000; ++i) lines += "a\n"; return lines; }());
+        CHECK(second_stream.str().size() == 4000);
+        CHECK(second_stream.str().find('a') == std::string::npos);
+    }
+
+    {
+        // new threads register their rings while another thread keeps draining
+        std::ostringstream stream;
+        {
+            Timed::AsyncSink sink(stream, Timed::Format("{name}"), { 2048, std::chrono::milliseconds(1) });
+            std::atomic<bool> done { false };
+            std::thread flusher([&] { while (!done.load()) sink.flush(); });
+            for (int t = 0; t < 16; ++t) {
+                std::thread writer([&] { for (int i = 0; i < 100; ++i) sink.write({ "r", here, 0, 1 }); });
+                writer.join();
+            }
+            done = true;
+            flusher.join();
+            CHECK(sink.get_dropped() == 0);
+        }
+        CHECK(stream.str().size() == 16 * 100 * 2);
+    }
+
+    {
+        // timers write one report per line to their output stream
+        std::ostringstream stream;
+        Timed::detail::BaseTimerSettings settings { "line", Timed::Format("{name}"), true, here, stream };
+        { Timed::FunctionTimer timer(settings, [] {}); }
+        { Timed::FunctionTimer timer(settings, [] {}); }
+        CHECK(stream.str() == "line\nline\n");
+    }
+
+    return check::finish();
+}
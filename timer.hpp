@@ -14,10 +14,42 @@
 
     Features:
       - No external dependencies, header-only, portable
-      - Automatic and average timers
+      - Automatic and average timers, with robust statistics (MAD, trimmed mean, Tukey
+        outliers) and an adaptive mode sampling until a target precision or time budget
       - Customizable output format with named placeholders:
             {filename}, {row}, {name}, {function}, {result}
+        parsed once (or at compile time with `"..."_fmt`) and rendered in a single pass
+      - Linux hardware counters (Timed::PerfCounters) with {cycles}, {instructions}, {ipc},
+        {l1_misses}, {llc_misses} and {branch_misses} placeholders
+      - Per-region allocation tracking (TIMED_TRACK_ALLOCATIONS) with {allocations},
+        {allocated_bytes} and {peak_bytes} placeholders
+      - Throughput of declared bytes or items per call with {throughput} (GB/s, Mitems/s, ...)
+        and {ns_per_item} placeholders
       - Uses std::chrono and std::source_location for precise timing and context
+      - Periodic background reports of the last window as a table or JSON lines (Timed::Reporter)
+      - Prometheus text exposition over HTTP and batched StatsD/UDP export
+        (Timed::write_prometheus, Timed::PrometheusExporter, Timed::StatsdExporter)
+      - Pluggable report sinks (Timed::Sink), including a non-blocking Timed::AsyncSink
+      - Process-wide per-site aggregation with Timed::Registry::snapshot(), sharded per CPU
+      - Lock-free log-linear latency histograms (Timed::Histogram) with percentiles
+      - Timed::tsc_clock, a calibrated time-stamp counter std Clock for the `clock` parameter
+      - Few-ns tagged timestamps for hot loops (Timed::mark, Timed::Marks::collect)
+      - 1-in-K sampling per site (`sample_every`) and a TIMED_DISABLE zero-cost switch
+      - Hierarchical profiling with inclusive and self time (Timed::ProfileTimer, Timed::Profiler)
+      - Coroutine task timers splitting active from suspended time (Timed::TaskTimer)
+      - Chrome Trace / Perfetto timeline export (Timed::TraceSink)
+      - Compact memory-mapped binary results files (Timed::BinaryWriter, Timed::BinaryReader)
+      - Calibrated micro-benchmarks (Timed::Benchmark) with optimizer barriers, compile-time
+        unrolled batches and an error bound on the per-call time
+      - Hot versus cold cache latency (Timed::CacheBenchmark, Timed::CacheFlusher)
+      - Multi-threaded throughput and scaling runs (Timed::ThreadedFunctionTimer)
+      - Benchmark environment pinning, priority, governor/turbo warnings and machine
+        metadata saved with baselines (Timed::Environment)
+      - Parameter sweeps with Big-O fitting (Timed::Sweep, Timed::geometric_range)
+      - Interleaved A/B comparisons with bootstrap intervals and a U test (Timed::Comparison)
+      - Saved baselines with regression detection and a CI exit status (Timed::Baseline)
+      - Benchmark registration (TIMED_BENCHMARK) and a command-line runner (TIMED_BENCHMARK_MAIN)
+        with filtering, repetitions, console/JSON/CSV/binary output and parallel runs
 
     Example usage:
 
@@ -27,11 +59,11 @@
         {
             {
                 // Time the foo function with 10 iterations
-                Timer::AverageTimer<10>({"foo"}, foo, 1, 2);
+                Timed::AverageFunctionTimer({{"foo"}, 10}, foo, 1, 2);
             }
             {
                 // Time the fibonacci function once and output the result in seconds
-                Timer::Timer<std::chrono::seconds>({"fibonacci"}, fibonacci, 41);
+                Timed::FunctionTimer<int, std::chrono::seconds>({"fibonacci"}, fibonacci, 41);
             }
         }
 
@@ -50,9 +82,8 @@
         - abstract the output formatting to a separate class
         - add more examples and documentation
         - add more tests and benchmarks
-        - add more statistics (variance, standard deviation, etc.)
         - add a results class to store the results of the timers
-        - add a way to save the results to a file or a database ?
+        - add a way to save the results to a database ?
 
 */
 
@@ -64,324 +95,6248 @@
 #include <array>            // std::array
 #include <numeric>          // std::accumulate
 #include <concepts>         // std::same_as, std::is_base_of_v, std::is_same_v
-#include <utility>          // std::forward
+#include <compare>          // operator<=>
+#include <utility>          // std::forward, std::pair
 #include <source_location>  // std::source_location
-#include <any>              // std::any
+#include <optional>         // std::optional
 #include <limits>           // std::numeric_limits
-#include <algorithm>        // std::sort
+#include <algorithm>        // std::sort, std::copy
+#include <charconv>         // std::to_chars
+#include <cstdint>          // std::uint8_t, std::uint16_t
+#include <iterator>         // std::ostreambuf_iterator, std::back_inserter
+#include <atomic>           // std::atomic
+#include <bit>              // std::bit_ceil
+#include <condition_variable> // std::condition_variable
+#include <memory>           // std::unique_ptr
+#include <mutex>            // std::mutex, std::lock_guard
+#include <thread>           // std::thread
+#include <unordered_map>    // std::unordered_map
+#include <vector>           // std::vector
+#include <functional>       // std::invoke
+#include <type_traits>      // std::invoke_result_t, std::is_trivially_copyable_v
+#include <cmath>            // std::sqrt
+#include <ratio>            // std::ratio
+#include <fstream>          // std::ofstream
+#include <deque>            // std::deque
+#include <cstring>          // std::memcpy
+#include <random>           // std::mt19937_64
+#include <map>              // std::map
+#include <coroutine>        // std::coroutine_handle
+#include <tuple>            // std::tuple, std::apply
+#include <ranges>           // std::ranges::contiguous_range
+#include <sstream>          // std::ostringstream
+#include <cerrno>           // errno
+#include <cstdlib>          // std::strtod
+
+// Memory-mapped results files (BinaryWriter, BinaryReader) need POSIX mmap.
+#if defined(__unix__) || defined(__APPLE__)
+    #define TIMED_HAS_MMAP 1
+    #include <fcntl.h>      // open
+    #include <sys/mman.h>   // mmap, munmap
+    #include <sys/stat.h>   // fstat
+    #include <unistd.h>     // ftruncate, close
+#else
+    #define TIMED_HAS_MMAP 0
+#endif
+
+// The Prometheus endpoint and the StatsD emitter use BSD sockets.
+#if defined(__unix__) || defined(__APPLE__)
+    #define TIMED_HAS_SOCKETS 1
+    #include <arpa/inet.h>  // inet_pton, htons
+    #include <netinet/in.h> // sockaddr_in
+    #include <poll.h>       // poll
+    #include <sys/socket.h> // socket, bind, sendto
+    #include <unistd.h>     // close
+    #if defined(MSG_NOSIGNAL)
+        #define TIMED_SEND_FLAGS MSG_NOSIGNAL // a scraper hanging up must not raise SIGPIPE
+    #else
+        #define TIMED_SEND_FLAGS 0
+    #endif
+#else
+    #define TIMED_HAS_SOCKETS 0
+#endif
+
+// Environment::detect reads the kernel version and hostname with POSIX uname.
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/utsname.h> // uname
+#endif
+
+// Thread pinning (ThreadedFunctionTimer::Settings::pin_threads) is only implemented on Linux.
+#if defined(__linux__)
+    #define TIMED_HAS_AFFINITY 1
+    #include <pthread.h>    // pthread_setaffinity_np
+    #include <sched.h>      // cpu_set_t, sched_getcpu
+    #include <sys/resource.h> // setpriority
+    #include <sys/syscall.h> // SYS_gettid
+#else
+    #define TIMED_HAS_AFFINITY 0
+#endif
+
+// Hardware performance counters (Timed::PerfCounters) use Linux perf_event_open.
+#if defined(__linux__)
+    #define TIMED_HAS_PERF 1
+    #include <linux/perf_event.h> // perf_event_attr, perf_event_mmap_page
+    #include <sys/ioctl.h>  // ioctl
+    #include <sys/syscall.h> // SYS_perf_event_open
+#else
+    #define TIMED_HAS_PERF 0
+#endif
+
+// Define TIMED_DISABLE to compile every timer into an empty, inlined no-op with the same API.
+// FunctionTimer still calls the function and keeps its result; nothing is measured or reported.
+#if defined(TIMED_DISABLE)
+    #define TIMED_ENABLED 0
+#else
+    #define TIMED_ENABLED 1
+#endif
 
 namespace Timed
 {
 
-    struct automatic_duration {};
+    struct automatic_duration {};
+
+    // Hardware event counts over a measurement, see Timed::PerfCounters.
+    struct Counters
+    {
+        std::uint64_t cycles = 0;
+        std::uint64_t instructions = 0;
+        std::uint64_t l1_misses = 0;     // L1 data cache read misses
+        std::uint64_t llc_misses = 0;    // last-level cache misses
+        std::uint64_t branch_misses = 0;
+
+        [[nodiscard]] constexpr double get_ipc() const noexcept
+        {
+            return cycles ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+        }
+
+        constexpr Counters& operator+=(const Counters& other) noexcept
+        {
+            cycles += other.cycles;
+            instructions += other.instructions;
+            l1_misses += other.l1_misses;
+            llc_misses += other.llc_misses;
+            branch_misses += other.branch_misses;
+            return *this;
+        }
+
+        [[nodiscard]] friend constexpr Counters operator-(const Counters& end, const Counters& start) noexcept
+        {
+            return { end.cycles - start.cycles, end.instructions - start.instructions, end.l1_misses - start.l1_misses,
+                     end.llc_misses - start.llc_misses, end.branch_misses - start.branch_misses };
+        }
+
+        // Counts per call, when `operations` calls were measured together.
+        [[nodiscard]] constexpr Counters per_op(std::uint64_t operations) const noexcept
+        {
+            if (operations == 0) return *this;
+            return { cycles / operations, instructions / operations, l1_misses / operations,
+                     llc_misses / operations, branch_misses / operations };
+        }
+    };
+
+    // Heap activity of the calling thread over a measurement, see TIMED_TRACK_ALLOCATIONS.
+    struct Allocations
+    {
+        std::uint64_t count = 0;      // calls to operator new
+        std::uint64_t bytes = 0;      // bytes requested
+        std::uint64_t peak_bytes = 0; // highest live bytes above the level at the start
+
+        constexpr Allocations& operator+=(const Allocations& other) noexcept
+        {
+            count += other.count;
+            bytes += other.bytes;
+            peak_bytes = std::max(peak_bytes, other.peak_bytes);
+            return *this;
+        }
+
+        // Count and bytes per call, when `operations` calls were measured together; the peak is kept.
+        [[nodiscard]] constexpr Allocations per_op(std::uint64_t operations) const noexcept
+        {
+            if (operations == 0) return *this;
+            return { count / operations, bytes / operations, peak_bytes };
+        }
+    };
+
+    // Data one call processes, declared through `BaseTimerSettings::bytes` and `items`, and the
+    // time the call took; shown by the `{throughput}` and `{ns_per_item}` placeholders.
+    struct Work
+    {
+        std::uint64_t bytes = 0;
+        std::uint64_t items = 0;
+        double elapsed = 0; // ns per call
+
+        [[nodiscard]] constexpr double get_bytes_per_second() const noexcept
+        {
+            return elapsed > 0 ? static_cast<double>(bytes) * 1e9 / elapsed : 0.0;
+        }
+        [[nodiscard]] constexpr double get_items_per_second() const noexcept
+        {
+            return elapsed > 0 ? static_cast<double>(items) * 1e9 / elapsed : 0.0;
+        }
+        [[nodiscard]] constexpr double get_ns_per_item() const noexcept
+        {
+            return items ? elapsed / static_cast<double>(items) : 0.0;
+        }
+    };
+
+
+    // Output format parsed once into a sequence of literal and placeholder segments.
+    // Parsing happens at compile time when the format is a constant expression (see `_fmt`):
+    // the format then refers to the literal and holds up to `max_segments` segments, more do
+    // not compile. Otherwise it is parsed once at construction into a heap copy of the string,
+    // shared by the copies of the Format, with no limit on the segments.
+    class Format
+    {
+    public:
+        enum class Field : std::uint8_t {
+            literal, filename, row, name, function, result,
+            cycles, instructions, ipc, l1_misses, llc_misses, branch_misses,
+            allocations, allocated_bytes, peak_bytes,
+            throughput, ns_per_item
+        };
+
+        struct Segment
+        {
+            Field field = Field::literal;
+            std::uint16_t offset = 0;
+            std::uint16_t length = 0;
+        };
+
+        // Values substituted for the placeholders when rendering.
+        struct Fields
+        {
+            std::string_view filename;
+            std::uint_least32_t row = 0;
+            std::string_view name;
+            std::string_view function;
+            std::string_view result;
+            // hardware counters and heap activity of the measurement, per call; null renders as "n/a"
+            const Counters* counters = nullptr;
+            const Allocations* allocations = nullptr;
+            // declared work of one call; null, or without bytes nor items, renders as "n/a"
+            const Work* work = nullptr;
+        };
+
+        static constexpr std::size_t max_segments = 24;
+
+    private:
+        // Owned copy of a runtime format; `source` views its text.
+        struct Storage
+        {
+            std::atomic<std::size_t> references { 1 };
+            std::string text;
+            std::vector<Segment> segments;
+        };
+
+        std::string_view source;
+        Storage* storage = nullptr;
+        std::array<Segment, max_segments> segments {};
+        std::size_t count = 0;
+
+        // Not a constant expression, so a literal format with too many segments fails to compile.
+        static void too_many_segments() noexcept {}
+
+        constexpr const Segment* data() const noexcept { return storage ? storage->segments.data() : segments.data(); }
+        constexpr Segment* data() noexcept { return storage ? storage->segments.data() : segments.data(); }
+
+        void release() noexcept
+        {
+            if (storage && storage->references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete storage;
+            storage = nullptr;
+        }
+
+        static constexpr Field placeholder(std::string_view token) noexcept
+        {
+            if (token == "{filename}") return Field::filename;
+            if (token == "{row}") return Field::row;
+            if (token == "{name}") return Field::name;
+            if (token == "{function}") return Field::function;
+            if (token == "{result}") return Field::result;
+            if (token == "{cycles}") return Field::cycles;
+            if (token == "{instructions}") return Field::instructions;
+            if (token == "{ipc}") return Field::ipc;
+            if (token == "{l1_misses}") return Field::l1_misses;
+            if (token == "{llc_misses}") return Field::llc_misses;
+            if (token == "{branch_misses}") return Field::branch_misses;
+            if (token == "{allocations}") return Field::allocations;
+            if (token == "{allocated_bytes}") return Field::allocated_bytes;
+            if (token == "{peak_bytes}") return Field::peak_bytes;
+            if (token == "{throughput}") return Field::throughput;
+            if (token == "{ns_per_item}") return Field::ns_per_item;
+            return Field::literal;
+        }
+
+        constexpr void push(Field field, std::size_t offset, std::size_t length)
+        {
+            if (length == 0 && field == Field::literal) return;
+            // merge adjacent literals, e.g. around an unknown `{...}`
+            if (field == Field::literal && count > 0) {
+                Segment& last = data()[count - 1];
+                if (last.field == Field::literal && last.offset + last.length == offset) {
+                    last.length = static_cast<std::uint16_t>(last.length + length);
+                    return;
+                }
+            }
+            const Segment segment { field, static_cast<std::uint16_t>(offset), static_cast<std::uint16_t>(length) };
+            if (storage) storage->segments.push_back(segment);
+            else if (count < max_segments) segments[count] = segment;
+            else return too_many_segments();
+            ++count;
+        }
+
+        constexpr void parse()
+        {
+            // longer formats are truncated to what a segment can address
+            if (source.size() > std::numeric_limits<std::uint16_t>::max())
+                source = source.substr(0, std::numeric_limits<std::uint16_t>::max());
+
+            std::size_t literal_start = 0;
+            std::size_t pos = 0;
+            while (pos < source.size()) {
+                if (source[pos] != '{') { ++pos; continue; }
+
+                std::size_t close = source.find('}', pos);
+                if (close == std::string_view::npos) break;
+
+                Field field = placeholder(source.substr(pos, close - pos + 1));
+                if (field == Field::literal) { ++pos; continue; }
+
+                push(Field::literal, literal_start, pos - literal_start);
+                push(field, pos, close - pos + 1);
+                pos = literal_start = close + 1;
+            }
+            push(Field::literal, literal_start, source.size() - literal_start);
+        }
+
+        template <typename Out>
+        static constexpr Out write(Out out, std::string_view text)
+        {
+            return std::copy(text.begin(), text.end(), out);
+        }
+
+        template <typename Out>
+        static Out write_counter(Out out, Field field, const Counters* counters)
+        {
+            if (!counters) return write(out, "n/a");
+
+            char buffer[32];
+            std::to_chars_result written;
+            if (field == Field::ipc) {
+                written = std::to_chars(buffer, buffer + sizeof(buffer), counters->get_ipc(), std::chars_format::fixed, 2);
+            } else {
+                std::uint64_t value = field == Field::cycles ? counters->cycles
+                                    : field == Field::instructions ? counters->instructions
+                                    : field == Field::l1_misses ? counters->l1_misses
+                                    : field == Field::llc_misses ? counters->llc_misses
+                                    : counters->branch_misses;
+                written = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            }
+            return write(out, std::string_view(buffer, written.ptr - buffer));
+        }
+
+        template <typename Out>
+        static Out write_allocations(Out out, Field field, const Allocations* allocations)
+        {
+            if (!allocations) return write(out, "n/a");
+
+            std::uint64_t value = field == Field::allocations ? allocations->count
+                                : field == Field::allocated_bytes ? allocations->bytes
+                                : allocations->peak_bytes;
+            char buffer[32];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            return write(out, std::string_view(buffer, end - buffer));
+        }
+
+        // Bytes per second with decimal units up to TB/s when bytes are declared, otherwise
+        // items per second up to Gitems/s, e.g. "12.345 GB/s"; or nanoseconds per item.
+        template <typename Out>
+        static Out write_work(Out out, Field field, const Work* work)
+        {
+            if (!work || work->elapsed <= 0 || (field == Field::ns_per_item ? !work->items : !work->bytes && !work->items))
+                return write(out, "n/a");
+
+            double value = field == Field::ns_per_item ? work->get_ns_per_item()
+                         : work->bytes ? work->get_bytes_per_second() : work->get_items_per_second();
+            std::string_view unit = " ns";
+            if (field == Field::throughput) {
+                constexpr std::string_view byte_units[] = { " B/s", " KB/s", " MB/s", " GB/s", " TB/s" };
+                constexpr std::string_view item_units[] = { " items/s", " Kitems/s", " Mitems/s", " Gitems/s", " Titems/s" };
+                std::size_t scale = 0;
+                while (value >= 1000 && scale + 1 < std::size(byte_units)) {
+                    value /= 1000;
+                    ++scale;
+                }
+                unit = work->bytes ? byte_units[scale] : item_units[scale];
+            }
+
+            char buffer[48];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer) - 16, value, std::chars_format::fixed, 3);
+            end = std::copy(unit.begin(), unit.end(), end);
+            return write(out, std::string_view(buffer, end - buffer));
+        }
+
+    public:
+        constexpr Format(std::string_view fmt)
+        {
+            if (std::is_constant_evaluated()) {
+                source = fmt;
+            } else {
+                storage = new Storage { 1, std::string(fmt), {} };
+                source = storage->text;
+            }
+            parse();
+        }
+        constexpr Format(const char* fmt) : Format(std::string_view(fmt)) {}
+        Format(const std::string& fmt) : Format(std::string_view(fmt)) {}
+
+        constexpr Format(const Format& other) noexcept
+            : source(other.source), storage(other.storage), segments(other.segments), count(other.count)
+        {
+            if (storage) storage->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        constexpr Format(Format&& other) noexcept
+            : source(other.source), storage(std::exchange(other.storage, nullptr)), segments(other.segments), count(other.count)
+        {
+        }
+
+        constexpr Format& operator=(Format other) noexcept
+        {
+            std::swap(source, other.source);
+            std::swap(storage, other.storage);
+            std::swap(segments, other.segments);
+            std::swap(count, other.count);
+            return *this;
+        }
+
+        // Constant-evaluated formats never own storage.
+        constexpr ~Format()
+        {
+            if (!std::is_constant_evaluated()) release();
+        }
+
+        [[nodiscard]] constexpr std::string_view str() const noexcept { return source; }
+        [[nodiscard]] constexpr std::size_t size() const noexcept { return count; }
+        [[nodiscard]] constexpr const Segment& operator[](std::size_t index) const noexcept { return data()[index]; }
+        // Whether the format refers to a literal rather than owning a copy.
+        [[nodiscard]] constexpr bool is_literal() const noexcept { return storage == nullptr; }
+
+        // Render the format in a single pass into `out`, without building temporaries.
+        template <typename Out>
+        Out render(Out out, const Fields& fields) const
+        {
+            const Segment* parsed = data();
+            for (std::size_t i = 0; i < count; ++i) {
+                const Segment& segment = parsed[i];
+                switch (segment.field) {
+                case Field::literal:  out = write(out, source.substr(segment.offset, segment.length)); break;
+                case Field::filename: out = write(out, fields.filename); break;
+                case Field::name:     out = write(out, fields.name); break;
+                case Field::function: out = write(out, fields.function); break;
+                case Field::result:   out = write(out, fields.result); break;
+                case Field::row: {
+                    char buffer[std::numeric_limits<std::uint_least32_t>::digits10 + 1];
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), fields.row);
+                    out = write(out, std::string_view(buffer, end - buffer));
+                    break;
+                }
+                case Field::cycles:
+                case Field::instructions:
+                case Field::ipc:
+                case Field::l1_misses:
+                case Field::llc_misses:
+                case Field::branch_misses:
+                    out = write_counter(out, segment.field, fields.counters);
+                    break;
+                case Field::allocations:
+                case Field::allocated_bytes:
+                case Field::peak_bytes:
+                    out = write_allocations(out, segment.field, fields.allocations);
+                    break;
+                case Field::throughput:
+                case Field::ns_per_item:
+                    out = write_work(out, segment.field, fields.work);
+                    break;
+                }
+            }
+            return out;
+        }
+    };
+
+    namespace literals
+    {
+        // Guarantees the format is parsed at compile time: `"{name} -> {result}"_fmt`
+        consteval Format operator""_fmt(const char* fmt, std::size_t size) noexcept
+        {
+            return Format(std::string_view(fmt, size));
+        }
+    } // namespace literals
+
+
+    // Compact, fixed-size description of one finished measurement, handed to a Sink.
+    // Timestamps are nanoseconds since the timer clock's epoch.
+    struct Record
+    {
+        std::string_view name;
+        std::source_location location;
+        int64_t start = 0;
+        int64_t end = 0;
+
+        [[nodiscard]] constexpr int64_t get_elapsed() const noexcept { return end - start; }
+    };
+
+    // Destination for timer reports, set through `BaseTimerSettings::sink`.
+    // Implementations must be safe to call concurrently from any thread.
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+        virtual void write(const Record& record) noexcept = 0;
+    };
+
+
+    namespace detail
+    {
+        // Write `text` as the contents of a JSON string.
+        inline void write_escaped(std::ostream& stream, std::string_view text)
+        {
+            for (char c : text) {
+                switch (c) {
+                case '"':  stream << "\\\""; break;
+                case '\\': stream << "\\\\"; break;
+                case '\n': stream << "\\n"; break;
+                case '\t': stream << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        constexpr char hex[] = "0123456789abcdef";
+                        stream << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                    } else {
+                        stream.put(c);
+                    }
+                }
+            }
+        }
+
+        // Log-linear bucketing of nanosecond values: exact below 2^sub_bucket_bits, then
+        // 2^(sub_bucket_bits - 1) buckets per power of two, i.e. < 1% relative error up to ~19h.
+        struct LogLinearBuckets
+        {
+            static constexpr unsigned sub_bucket_bits = 7;
+            static constexpr unsigned max_value_bits = 46;
+            static constexpr int64_t sub_bucket_count = int64_t(1) << sub_bucket_bits;
+            static constexpr int64_t half_count = sub_bucket_count / 2;
+            static constexpr std::size_t count = sub_bucket_count + (max_value_bits - sub_bucket_bits) * half_count;
+            static constexpr int64_t max_value = (int64_t(1) << max_value_bits) - 1;
+
+            static constexpr std::size_t index(int64_t value) noexcept
+            {
+                value = std::clamp<int64_t>(value, 0, max_value);
+                if (value < sub_bucket_count) return static_cast<std::size_t>(value);
+                unsigned shift = static_cast<unsigned>(std::bit_width(static_cast<std::uint64_t>(value))) - sub_bucket_bits;
+                int64_t top = value >> shift;
+                return static_cast<std::size_t>(sub_bucket_count + (shift - 1) * half_count + (top - half_count));
+            }
+
+            static constexpr int64_t lower_bound(std::size_t index) noexcept
+            {
+                if (index < static_cast<std::size_t>(sub_bucket_count)) return static_cast<int64_t>(index);
+                std::size_t offset = index - sub_bucket_count;
+                unsigned shift = static_cast<unsigned>(offset / half_count) + 1;
+                return (half_count + static_cast<int64_t>(offset % half_count)) << shift;
+            }
+
+            static constexpr int64_t upper_bound(std::size_t index) noexcept
+            {
+                return index + 1 < count ? lower_bound(index + 1) - 1 : max_value;
+            }
+        };
+
+        // Identifies a timing site by the location's addresses and the name's content.
+        struct SiteKey
+        {
+            const char* file;
+            std::uint_least32_t line;
+            std::uint_least32_t column;
+            std::string_view name;
+
+            bool operator==(const SiteKey&) const noexcept = default;
+        };
+
+        struct SiteKeyHash
+        {
+            std::size_t operator()(const SiteKey& key) const noexcept
+            {
+                std::size_t hash = std::hash<std::string_view>{}(key.name);
+                hash ^= std::hash<const void*>{}(key.file) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+                hash ^= (std::size_t(key.line) << 20 | key.column) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+                return hash;
+            }
+        };
+
+        inline void atomic_min(std::atomic<int64_t>& target, int64_t value) noexcept
+        {
+            int64_t current = target.load(std::memory_order_relaxed);
+            while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+
+        inline void atomic_max(std::atomic<int64_t>& target, int64_t value) noexcept
+        {
+            int64_t current = target.load(std::memory_order_relaxed);
+            while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+    } // namespace detail
+
+
+    // Fixed-memory latency histogram with log-linear buckets from 1 ns to ~19 hours (< 1% error).
+    // Recording is O(1) and lock-free, so any number of threads may share one histogram.
+    class Histogram
+    {
+    public:
+        using Buckets = detail::LogLinearBuckets;
+
+        // Plain, mergeable copy of a histogram's state, also usable as a single-threaded histogram.
+        class Snapshot
+        {
+        private:
+            std::array<std::uint64_t, Buckets::count> buckets {};
+            std::uint64_t count = 0;
+            int64_t total = 0;
+            int64_t lowest = std::numeric_limits<int64_t>::max();
+            int64_t highest = std::numeric_limits<int64_t>::min();
+
+            friend class Histogram;
+            friend class Baseline;
+
+        public:
+            void record(int64_t value) noexcept
+            {
+                ++buckets[Buckets::index(value)];
+                ++count;
+                total += value;
+                lowest = std::min(lowest, value);
+                highest = std::max(highest, value);
+            }
+
+            void merge(const Snapshot& other) noexcept
+            {
+                for (std::size_t i = 0; i < Buckets::count; ++i) buckets[i] += other.buckets[i];
+                count += other.count;
+                total += other.total;
+                lowest = std::min(lowest, other.lowest);
+                highest = std::max(highest, other.highest);
+            }
+
+            [[nodiscard]] std::uint64_t get_count() const noexcept { return count; }
+            [[nodiscard]] int64_t get_total() const noexcept { return total; }
+            [[nodiscard]] int64_t get_min() const noexcept { return count ? lowest : 0; }
+            [[nodiscard]] int64_t get_max() const noexcept { return count ? highest : 0; }
+            [[nodiscard]] int64_t get_average() const noexcept { return count ? total / static_cast<int64_t>(count) : 0; }
+            [[nodiscard]] std::uint64_t get_bucket(std::size_t index) const noexcept { return buckets[index]; }
+
+            // Midpoint of the bucket holding the quantile in [0, 1], clamped to [min, max].
+            [[nodiscard]] int64_t get_percentile(double quantile) const noexcept
+            {
+                if (count == 0) return 0;
+
+                auto rank = static_cast<std::uint64_t>(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count - 1)) + 1;
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < Buckets::count; ++i) {
+                    seen += buckets[i];
+                    if (seen >= rank) {
+                        int64_t lower = Buckets::lower_bound(i);
+                        int64_t middle = lower + (Buckets::upper_bound(i) - lower) / 2;
+                        return std::clamp(middle, lowest, highest);
+                    }
+                }
+                return highest;
+            }
+        };
+
+    private:
+        std::array<std::atomic<std::uint64_t>, Buckets::count> buckets {};
+        std::atomic<std::uint64_t> count { 0 };
+        std::atomic<int64_t> total { 0 };
+        std::atomic<int64_t> lowest { std::numeric_limits<int64_t>::max() };
+        std::atomic<int64_t> highest { std::numeric_limits<int64_t>::min() };
+
+    public:
+        Histogram() noexcept = default;
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+        // Add one sample, in nanoseconds.
+        void record(int64_t value) noexcept
+        {
+            buckets[Buckets::index(value)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(value, std::memory_order_relaxed);
+            detail::atomic_min(lowest, value);
+            detail::atomic_max(highest, value);
+        }
+
+        void merge(const Snapshot& other) noexcept
+        {
+            for (std::size_t i = 0; i < Buckets::count; ++i)
+                if (other.buckets[i]) buckets[i].fetch_add(other.buckets[i], std::memory_order_relaxed);
+            count.fetch_add(other.count, std::memory_order_relaxed);
+            total.fetch_add(other.total, std::memory_order_relaxed);
+            detail::atomic_min(lowest, other.lowest);
+            detail::atomic_max(highest, other.highest);
+        }
+
+        // Copy of the current state; consistent per counter while recorders are running.
+        [[nodiscard]] Snapshot snapshot() const noexcept
+        {
+            Snapshot snapshot;
+            for (std::size_t i = 0; i < Buckets::count; ++i) snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            snapshot.count = count.load(std::memory_order_relaxed);
+            snapshot.total = total.load(std::memory_order_relaxed);
+            snapshot.lowest = lowest.load(std::memory_order_relaxed);
+            snapshot.highest = highest.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        // Snapshot and reset in one pass: each counter is swapped for its initial value, so
+        // concurrent recorders are never lost nor blocked, only possibly split across windows.
+        [[nodiscard]] Snapshot collect() noexcept
+        {
+            Snapshot snapshot;
+            for (std::size_t i = 0; i < Buckets::count; ++i) snapshot.buckets[i] = buckets[i].exchange(0, std::memory_order_relaxed);
+            snapshot.count = count.exchange(0, std::memory_order_relaxed);
+            snapshot.total = total.exchange(0, std::memory_order_relaxed);
+            snapshot.lowest = lowest.exchange(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+            snapshot.highest = highest.exchange(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        void reset() noexcept
+        {
+            for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+            count.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            lowest.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+            highest.store(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] int64_t get_percentile(double quantile) const noexcept { return snapshot().get_percentile(quantile); }
+    };
+
+
+#ifndef TIMED_MAX_SHARDS
+    #define TIMED_MAX_SHARDS 64 // upper bound of Registry shards per site, a power of two
+#endif
+
+    // Process-wide aggregation of timings per site, keyed by source location and name.
+    // Every site keeps cache-line aligned shards of atomic counters and a log2 histogram, one
+    // per CPU (up to TIMED_MAX_SHARDS); a recorder only touches the shard of the CPU it runs
+    // on, so no cache line is shared between cores, and `snapshot()` merges them on demand.
+    class Registry
+    {
+    public:
+        static constexpr std::size_t bucket_count = 64;
+
+        // Merged view of one site. Bucket i counts samples below 2^i ns (and at least 2^(i-1) ns).
+        struct Summary
+        {
+            std::string_view name;
+            std::source_location location;
+            std::uint64_t count = 0;
+            int64_t sum = 0;
+            int64_t min = std::numeric_limits<int64_t>::max();
+            int64_t max = std::numeric_limits<int64_t>::min();
+            std::array<std::uint64_t, bucket_count> buckets {};
+
+            [[nodiscard]] int64_t get_average() const noexcept { return count ? sum / static_cast<int64_t>(count) : 0; }
+
+            // Upper bound of the bucket holding the given quantile, clamped to [min, max].
+            [[nodiscard]] int64_t get_percentile(double quantile) const noexcept
+            {
+                if (count == 0) return 0;
+                auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(count - 1)) + 1;
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < bucket_count; ++i) {
+                    seen += buckets[i];
+                    if (seen >= rank) {
+                        int64_t upper = i == 0 ? 0 : static_cast<int64_t>((std::uint64_t(1) << i) - 1);
+                        return std::clamp(upper, min, max);
+                    }
+                }
+                return max;
+            }
+        };
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<std::uint64_t> count { 0 };
+            std::atomic<int64_t> sum { 0 };
+            std::atomic<int64_t> min { std::numeric_limits<int64_t>::max() };
+            std::atomic<int64_t> max { std::numeric_limits<int64_t>::min() };
+            std::array<std::atomic<std::uint64_t>, bucket_count> buckets {};
+        };
+
+        struct Site
+        {
+            std::string name;
+            std::source_location location;
+            std::unique_ptr<Shard[]> shards = std::make_unique<Shard[]>(get_shard_count());
+        };
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Site>> sites;
+        // keyed by content so the same site reached through different string addresses is merged
+        std::unordered_map<std::string, Site*> index;
+
+        Registry() = default;
+
+        // The current CPU where the OS reports it (sched_getcpu reads the rseq area on recent
+        // glibc), otherwise a per-thread round-robin slot. Either way a migration only costs
+        // locality: shards are atomic, so two threads sharing one stay correct.
+        static std::size_t shard_index() noexcept
+        {
+            static std::atomic<std::size_t> threads { 0 };
+            thread_local std::size_t slot = threads.fetch_add(1, std::memory_order_relaxed);
+#if TIMED_HAS_AFFINITY
+            if (int cpu = sched_getcpu(); cpu >= 0) return static_cast<std::size_t>(cpu) & (get_shard_count() - 1);
+#endif
+            return slot & (get_shard_count() - 1);
+        }
+
+        static std::size_t bucket_index(int64_t elapsed) noexcept
+        {
+            if (elapsed <= 0) return 0;
+            return std::min<std::size_t>(std::bit_width(static_cast<std::uint64_t>(elapsed)), bucket_count - 1);
+        }
+
+        Site* find_or_create(std::string_view name, const std::source_location& location)
+        {
+            std::string key;
+            key.append(location.file_name()).append(":").append(std::to_string(location.line()))
+               .append(":").append(std::to_string(location.column())).append(":").append(location.function_name())
+               .append(":").append(name);
+
+            std::lock_guard lock(mutex);
+            auto& site = index[std::move(key)];
+            if (!site) {
+                sites.push_back(std::make_unique<Site>());
+                site = sites.back().get();
+                site->name = name;
+                site->location = location;
+            }
+            return site;
+        }
+
+        Site* site(std::string_view name, const std::source_location& location)
+        {
+            // sites are never destroyed, so each thread caches its lookups without locking
+            thread_local std::unordered_map<detail::SiteKey, Site*, detail::SiteKeyHash> cache;
+
+            detail::SiteKey key { location.file_name(), location.line(), location.column(), name };
+            if (auto it = cache.find(key); it != cache.end()) return it->second;
+
+            Site* found = find_or_create(name, location);
+            key.name = found->name;
+            cache.emplace(key, found);
+            return found;
+        }
+
+    public:
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+        Registry(Registry&&) = delete;
+        Registry& operator=(Registry&&) = delete;
+
+        // Intentionally leaked so threads may still record during static destruction.
+        static Registry& instance() noexcept
+        {
+            static Registry* registry = new Registry();
+            return *registry;
+        }
+
+        // Shards per site: the CPU count rounded up to a power of two, at most TIMED_MAX_SHARDS.
+        static std::size_t get_shard_count() noexcept
+        {
+            static_assert(std::has_single_bit(std::size_t(TIMED_MAX_SHARDS)), "TIMED_MAX_SHARDS must be a power of two");
+            static const std::size_t count = std::min<std::size_t>(
+                std::bit_ceil(std::max(std::thread::hardware_concurrency(), 1u)), TIMED_MAX_SHARDS);
+            return count;
+        }
+
+        // Add one sample of `elapsed` nanoseconds to the site.
+        static void record(std::string_view name, const std::source_location& location, int64_t elapsed) noexcept
+        {
+            Site* site;
+            try { site = instance().site(name, location); }
+            catch (...) { return; }
+
+            Shard& shard = site->shards[shard_index()];
+            shard.count.fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(elapsed, std::memory_order_relaxed);
+            detail::atomic_min(shard.min, elapsed);
+            detail::atomic_max(shard.max, elapsed);
+            shard.buckets[bucket_index(elapsed)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Merge the shards of every site. Concurrent recorders are not blocked, so a
+        // snapshot taken under load is consistent per counter, not across counters.
+        static std::vector<Summary> snapshot()
+        {
+            Registry& registry = instance();
+            std::lock_guard lock(registry.mutex);
+
+            std::vector<Summary> summaries;
+            summaries.reserve(registry.sites.size());
+            for (const auto& site : registry.sites) {
+                Summary summary { site->name, site->location };
+                for (std::size_t s = 0; s < get_shard_count(); ++s) {
+                    const Shard& shard = site->shards[s];
+                    summary.count += shard.count.load(std::memory_order_relaxed);
+                    summary.sum += shard.sum.load(std::memory_order_relaxed);
+                    summary.min = std::min(summary.min, shard.min.load(std::memory_order_relaxed));
+                    summary.max = std::max(summary.max, shard.max.load(std::memory_order_relaxed));
+                    for (std::size_t i = 0; i < bucket_count; ++i)
+                        summary.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+                }
+                summaries.push_back(summary);
+            }
+            return summaries;
+        }
+
+        // Like `snapshot()`, but every counter is read and reset in one atomic exchange, so the
+        // next call covers only what was recorded in between. Recorders are never blocked; one
+        // racing with the reset may have its count and sum land in different windows.
+        static std::vector<Summary> collect()
+        {
+            Registry& registry = instance();
+            std::lock_guard lock(registry.mutex);
+
+            std::vector<Summary> summaries;
+            summaries.reserve(registry.sites.size());
+            for (const auto& site : registry.sites) {
+                Summary summary { site->name, site->location };
+                for (std::size_t s = 0; s < get_shard_count(); ++s) {
+                    Shard& shard = site->shards[s];
+                    summary.count += shard.count.exchange(0, std::memory_order_relaxed);
+                    summary.sum += shard.sum.exchange(0, std::memory_order_relaxed);
+                    summary.min = std::min(summary.min, shard.min.exchange(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed));
+                    summary.max = std::max(summary.max, shard.max.exchange(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed));
+                    for (std::size_t i = 0; i < bucket_count; ++i)
+                        summary.buckets[i] += shard.buckets[i].exchange(0, std::memory_order_relaxed);
+                }
+                summaries.push_back(summary);
+            }
+            return summaries;
+        }
+    };
+
+
+    namespace detail
+    {
+        // Two-sided p-value of the Mann-Whitney U test, normal approximation with tie correction.
+        // Fed one group of tied samples at a time, in increasing order, with how many of the
+        // group come from each side; both the sample and the histogram versions reduce to this.
+        class MannWhitney
+        {
+            double na = 0, nb = 0, rank_sum_a = 0, ties = 0;
+
+        public:
+            void add_ties(double from_a, double from_b) noexcept
+            {
+                double t = from_a + from_b;
+                if (t == 0) return;
+                rank_sum_a += from_a * (na + nb + (t + 1) / 2); // average of the group's ranks
+                ties += t * t * t - t;
+                na += from_a;
+                nb += from_b;
+            }
+
+            [[nodiscard]] double p_value() const noexcept
+            {
+                if (na == 0 || nb == 0) return 1.0;
+                const double n = na + nb;
+                const double u = rank_sum_a - na * (na + 1) / 2;
+                const double sigma = std::sqrt(na * nb / 12 * ((n + 1) - ties / (n * (n - 1))));
+                if (sigma == 0) return 1.0;
+                double z = (std::abs(u - na * nb / 2) - 0.5) / sigma;
+                return std::erfc(std::max(z, 0.0) / std::sqrt(2.0));
+            }
+        };
+
+        // Mann-Whitney U p-value for two histograms, each bucket being a group of ties.
+        inline double mann_whitney_p(const Histogram::Snapshot& a, const Histogram::Snapshot& b) noexcept
+        {
+            MannWhitney test;
+            for (std::size_t i = 0; i < Histogram::Buckets::count; ++i)
+                test.add_ties(static_cast<double>(a.get_bucket(i)), static_cast<double>(b.get_bucket(i)));
+            return test.p_value();
+        }
+    } // namespace detail
+
+
+    // Named per-site timing distributions, saved to and loaded from a text file so runs can be
+    // compared across builds. Timers feed it through `BaseTimerSettings::baseline`, keyed by
+    // their name; AverageFunctionTimer records every iteration. `compare()` flags sites whose
+    // median or p99 grew beyond a threshold while a Mann-Whitney U test finds the shift significant.
+    class Baseline
+    {
+    public:
+        struct Thresholds
+        {
+            double median = 0.05;   // relative growth of the median, e.g. 5%
+            double p99 = 0.10;      // relative growth of the 99th percentile
+            double alpha = 0.01;    // significance level of the U test
+        };
+
+        struct Site
+        {
+            std::string name;
+            int64_t baseline_median = 0; // ns
+            int64_t median = 0;
+            int64_t baseline_p99 = 0;
+            int64_t p99 = 0;
+            double p_value = 1;
+            bool is_new = false;         // not present in the baseline
+            bool regressed = false;
+        };
+
+        struct Report
+        {
+            std::vector<Site> sites;
+            // "key: baseline -> current" for every metadata entry that differs between the runs
+            std::vector<std::string> environment_changes;
+
+            [[nodiscard]] bool regressed() const noexcept
+            {
+                return std::any_of(sites.begin(), sites.end(), [](const Site& site) { return site.regressed; });
+            }
+
+            // Process exit status for CI: 1 when any site regressed, 0 otherwise.
+            [[nodiscard]] int exit_status() const noexcept { return regressed() ? 1 : 0; }
+
+            void write(std::ostream& stream) const
+            {
+                for (const Site& site : sites) {
+                    stream << (site.regressed ? "REGRESSED " : site.is_new ? "NEW       " : "ok        ") << site.name
+                           << ": median " << site.baseline_median << " -> " << site.median << " ns, p99 "
+                           << site.baseline_p99 << " -> " << site.p99 << " ns, p = " << site.p_value << '\n';
+                }
+                for (const std::string& change : environment_changes) stream << "environment changed: " << change << '\n';
+            }
+        };
+
+    private:
+        static constexpr std::string_view header = "timed-baseline 1";
+
+        mutable std::mutex mutex;
+        std::map<std::string, Histogram::Snapshot, std::less<>> sites;
+        std::map<std::string, std::string, std::less<>> metadata;
+
+        Histogram::Snapshot& site(std::string_view name)
+        {
+            auto it = sites.find(name);
+            if (it == sites.end()) it = sites.emplace(std::string(name), Histogram::Snapshot {}).first;
+            return it->second;
+        }
+
+    public:
+        Baseline() = default;
+        Baseline(const Baseline&) = delete;
+        Baseline& operator=(const Baseline&) = delete;
+
+        void record(std::string_view name, int64_t elapsed) noexcept
+        {
+            try {
+                std::lock_guard lock(mutex);
+                site(name).record(elapsed);
+            } catch (...) {}
+        }
+
+        void merge(std::string_view name, const Histogram::Snapshot& snapshot)
+        {
+            std::lock_guard lock(mutex);
+            site(name).merge(snapshot);
+        }
+
+        // Copy of a site's distribution, empty if it was never recorded.
+        [[nodiscard]] Histogram::Snapshot get(std::string_view name) const
+        {
+            std::lock_guard lock(mutex);
+            auto it = sites.find(name);
+            return it == sites.end() ? Histogram::Snapshot {} : it->second;
+        }
+
+        [[nodiscard]] std::vector<std::string> get_names() const
+        {
+            std::lock_guard lock(mutex);
+            std::vector<std::string> names;
+            for (const auto& [name, snapshot] : sites) names.push_back(name);
+            return names;
+        }
+
+        // Describe the run, e.g. with Environment::Metadata::entries(); saved with the baseline
+        // and compared by `compare()`. Newlines in keys and values are replaced by spaces.
+        void set_metadata(std::string_view key, std::string_view value)
+        {
+            auto clean = [](std::string_view text) {
+                std::string out(text);
+                std::replace(out.begin(), out.end(), '\n', ' ');
+                return out;
+            };
+            std::lock_guard lock(mutex);
+            metadata.insert_or_assign(clean(key), clean(value));
+        }
+
+        [[nodiscard]] std::map<std::string, std::string, std::less<>> get_metadata() const
+        {
+            std::lock_guard lock(mutex);
+            return metadata;
+        }
+
+        // Metadata lines `# key = value` after the header, then one line per site: count, total,
+        // min, max, the non-empty `index:count` buckets, then the name up to the end of the line.
+        // Returns false if the file could not be written.
+        bool save(const std::string& path) const
+        {
+            std::ofstream file(path, std::ios::trunc);
+            if (!file) return false;
+
+            std::lock_guard lock(mutex);
+            file << header << '\n';
+            for (const auto& [key, value] : metadata) file << "# " << key << " = " << value << '\n';
+            for (const auto& [name, snapshot] : sites) {
+                file << snapshot.count << ' ' << snapshot.total << ' ' << snapshot.lowest << ' ' << snapshot.highest;
+                for (std::size_t i = 0; i < Histogram::Buckets::count; ++i)
+                    if (snapshot.buckets[i]) file << ' ' << i << ':' << snapshot.buckets[i];
+                file << " | ";
+                for (char c : name) file << (c == '\n' ? ' ' : c);
+                file << '\n';
+            }
+            return static_cast<bool>(file.flush());
+        }
+
+        // Replace the contents with a saved baseline. Returns false, leaving it empty, if the
+        // file is missing or not a baseline.
+        bool load(const std::string& path)
+        {
+            std::ifstream file(path);
+            std::string line;
+            std::lock_guard lock(mutex);
+            sites.clear();
+            metadata.clear();
+            if (!std::getline(file, line) || line != header) return false;
+
+            while (std::getline(file, line)) {
+                if (line.starts_with("# ")) {
+                    auto equals = line.find(" = ");
+                    if (equals != std::string::npos) metadata.insert_or_assign(line.substr(2, equals - 2), line.substr(equals + 3));
+                    continue;
+                }
+                auto separator = line.find(" | ");
+                if (separator == std::string::npos) continue;
+
+                Histogram::Snapshot snapshot;
+                const char* at = line.data();
+                const char* end = line.data() + separator;
+                auto number = [&](auto& value) {
+                    while (at < end && *at == ' ') ++at;
+                    at = std::from_chars(at, end, value).ptr;
+                };
+                number(snapshot.count);
+                number(snapshot.total);
+                number(snapshot.lowest);
+                number(snapshot.highest);
+                while (at < end) {
+                    std::size_t index = 0;
+                    std::uint64_t count = 0;
+                    number(index);
+                    if (at < end && *at == ':') ++at;
+                    number(count);
+                    if (index < Histogram::Buckets::count) snapshot.buckets[index] = count;
+                    if (count == 0) break;
+                }
+                sites.insert_or_assign(line.substr(separator + 3), snapshot);
+            }
+            return true;
+        }
+
+        // Compare this run against `baseline`. Sites missing from this run are ignored.
+        [[nodiscard]] Report compare(const Baseline& baseline, Thresholds thresholds) const
+        {
+            // comparing a baseline with itself must not lock its mutex twice
+            std::unique_lock own(mutex, std::defer_lock), other(baseline.mutex, std::defer_lock);
+            if (&baseline == this) own.lock();
+            else std::lock(own, other);
+            Report report;
+            for (const auto& [name, current] : sites) {
+                Site site { name, 0, current.get_percentile(0.5), 0, current.get_percentile(0.99) };
+                auto it = baseline.sites.find(name);
+                if (it == baseline.sites.end() || it->second.get_count() == 0) {
+                    site.is_new = true;
+                    report.sites.push_back(site);
+                    continue;
+                }
+
+                const Histogram::Snapshot& before = it->second;
+                site.baseline_median = before.get_percentile(0.5);
+                site.baseline_p99 = before.get_percentile(0.99);
+                site.p_value = detail::mann_whitney_p(before, current);
+
+                auto grew = [](int64_t from, int64_t to, double threshold) {
+                    return static_cast<double>(to) > static_cast<double>(from) * (1 + threshold);
+                };
+                bool slower = grew(site.baseline_median, site.median, thresholds.median)
+                           || grew(site.baseline_p99, site.p99, thresholds.p99);
+                site.regressed = slower && site.p_value < thresholds.alpha;
+                report.sites.push_back(site);
+            }
+            for (const auto& [key, value] : metadata) {
+                auto it = baseline.metadata.find(key);
+                if (it != baseline.metadata.end() && it->second != value)
+                    report.environment_changes.push_back(key + ": " + it->second + " -> " + value);
+            }
+            return report;
+        }
+
+        [[nodiscard]] Report compare(const Baseline& baseline) const { return compare(baseline, Thresholds {}); }
+    };
+
+
+    // Clock reading the CPU time-stamp counter: RDTSC on x86 (fenced with LFENCE so the read
+    // is not reordered around the timed code), CNTVCT_EL0 on AArch64, steady_clock elsewhere.
+    // A std Clock: `now()` converts the counter to nanoseconds since the calibration with a
+    // ticks-per-ns ratio measured once against steady_clock, so durations work with
+    // `duration_cast` and any `clock` parameter. The conversion follows the counter read, so an
+    // interval only includes it once, at its start. Call `calibrate()` at startup to keep the
+    // ~10 ms calibration out of the first report. Assumes an invariant TSC.
+    struct tsc_clock
+    {
+        using rep = int64_t;
+        using period = std::nano;
+        using duration = std::chrono::nanoseconds;
+        using time_point = std::chrono::time_point<tsc_clock>;
+        static constexpr bool is_steady = true;
+
+        static time_point now() noexcept { return time_point(from_ticks(read())); }
+
+        // Raw counter without the fences: cheaper, but the read may drift a few instructions
+        // into the surrounding code. Meant for `Timed::mark` and other dense instrumentation.
+        static rep ticks() noexcept { return read<false>(); }
+
+        // Position of a raw counter value on the `now()` time line.
+        static duration from_ticks(rep ticks) noexcept
+        {
+            const Calibration& calibration = calibrated();
+            return duration(static_cast<rep>(static_cast<double>(ticks - calibration.base) * calibration.ns_per_tick));
+        }
+
+        static double calibrate() noexcept { return calibrated().ticks_per_ns; }
+        static double ticks_per_ns() noexcept { return calibrate(); }
+
+    private:
+        template <bool fenced = true>
+        static rep read() noexcept
+        {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            std::uint32_t low, high;
+            if constexpr (fenced) asm volatile("lfence\n\trdtsc\n\tlfence" : "=a"(low), "=d"(high) : : "memory");
+            else asm volatile("rdtsc" : "=a"(low), "=d"(high));
+            return static_cast<rep>((std::uint64_t(high) << 32) | low);
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+            std::uint64_t ticks;
+            if constexpr (fenced) asm volatile("isb\n\tmrs %0, cntvct_el0\n\tisb" : "=r"(ticks) : : "memory");
+            else asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+            return static_cast<rep>(ticks);
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        struct Calibration
+        {
+            double ticks_per_ns;
+            double ns_per_tick; // multiplied rather than divided by in `now()`
+            rep base;           // counter at the calibration, the epoch of `now()`
+        };
+
+        static const Calibration& calibrated() noexcept
+        {
+            static const Calibration calibration = [] {
+                const double ratio = measure_ticks_per_ns();
+                return Calibration { ratio, 1 / ratio, read() };
+            }();
+            return calibration;
+        }
+
+        static double measure_ticks_per_ns() noexcept
+        {
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+            std::uint64_t frequency;
+            asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+            if (frequency) return static_cast<double>(frequency) / 1e9;
+#elif !((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+            return 1.0;
+#endif
+            // busy-wait rather than sleep so frequency scaling settles before sampling
+            auto wall_start = std::chrono::steady_clock::now();
+            rep tick_start = read();
+            auto wall_end = wall_start;
+            while (wall_end - wall_start < std::chrono::milliseconds(10)) wall_end = std::chrono::steady_clock::now();
+            rep tick_end = read();
+            double elapsed = std::chrono::duration<double, std::nano>(wall_end - wall_start).count();
+            return static_cast<double>(tick_end - tick_start) / elapsed;
+        }
+    };
+
+
+    // Per-thread group of hardware counters (cycles, instructions, L1D read misses, LLC misses,
+    // branch misses) opened with perf_event_open on the calling thread, user space only.
+    // Counters are read with RDPMC from the mapped event pages when the kernel allows it, with
+    // read(2) as the fallback. Unsupported events read as 0; when the group cannot be opened at
+    // all (no PMU, perf_event_paranoid, other OSes) `is_open()` is false and timers report "n/a".
+#if TIMED_HAS_PERF
+    class PerfCounters
+    {
+    private:
+        struct Event
+        {
+            int fd = -1;
+            perf_event_mmap_page* page = nullptr;
+        };
+
+        std::array<Event, 5> events;
+
+        static int open_event(std::uint32_t type, std::uint64_t config, int group) noexcept
+        {
+            perf_event_attr attr {};
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = group < 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+        }
+
+        static std::uint64_t read_event(const Event& event) noexcept
+        {
+            if (event.fd < 0) return 0;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            if (const volatile perf_event_mmap_page* page = event.page) {
+                // seqlock protocol from linux/perf_event.h
+                std::uint32_t sequence;
+                std::uint64_t value;
+                bool direct;
+                do {
+                    sequence = page->lock;
+                    asm volatile("" : : : "memory");
+                    std::uint32_t index = page->index;
+                    value = static_cast<std::uint64_t>(page->offset);
+                    direct = page->cap_user_rdpmc && index;
+                    if (direct) {
+                        std::uint32_t low, high;
+                        asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(index - 1));
+                        unsigned shift = 64 - page->pmc_width;
+                        auto count = static_cast<int64_t>((std::uint64_t(high) << 32) | low);
+                        value += static_cast<std::uint64_t>(static_cast<int64_t>(static_cast<std::uint64_t>(count) << shift) >> shift);
+                    }
+                    asm volatile("" : : : "memory");
+                } while (page->lock != sequence);
+                if (direct) return value;
+            }
+#endif
+            std::uint64_t value = 0;
+            if (::read(event.fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) return 0;
+            return value;
+        }
+
+    public:
+        PerfCounters() noexcept
+        {
+            constexpr std::uint64_t l1_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const std::array<std::pair<std::uint32_t, std::uint64_t>, 5> configs { {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+                { PERF_TYPE_HW_CACHE, l1_read_miss },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            } };
+
+            events[0].fd = open_event(configs[0].first, configs[0].second, -1);
+            if (events[0].fd < 0) return;
+            for (std::size_t i = 1; i < events.size(); ++i) events[i].fd = open_event(configs[i].first, configs[i].second, events[0].fd);
+
+            const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            for (auto& event : events) {
+                if (event.fd < 0) continue;
+                void* page = mmap(nullptr, page_size, PROT_READ, MAP_SHARED, event.fd, 0);
+                if (page != MAP_FAILED) event.page = static_cast<perf_event_mmap_page*>(page);
+            }
+
+            ioctl(events[0].fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(events[0].fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        ~PerfCounters()
+        {
+            const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            for (auto& event : events) {
+                if (event.page) munmap(event.page, page_size);
+                if (event.fd >= 0) ::close(event.fd);
+            }
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        PerfCounters(PerfCounters&&) = delete;
+        PerfCounters& operator=(PerfCounters&&) = delete;
+
+        [[nodiscard]] bool is_open() const noexcept { return events[0].fd >= 0; }
+
+        // Running totals since the group was opened; subtract two reads for a measurement.
+        [[nodiscard]] Counters read() const noexcept
+        {
+            return { read_event(events[0]), read_event(events[1]), read_event(events[2]),
+                     read_event(events[3]), read_event(events[4]) };
+        }
+
+        // Counters of the calling thread, opened on first use.
+        static PerfCounters& local() noexcept
+        {
+            thread_local PerfCounters counters;
+            return counters;
+        }
+    };
+#else
+    class PerfCounters
+    {
+    public:
+        [[nodiscard]] constexpr bool is_open() const noexcept { return false; }
+        [[nodiscard]] constexpr Counters read() const noexcept { return {}; }
+
+        static PerfCounters& local() noexcept
+        {
+            static PerfCounters counters;
+            return counters;
+        }
+    };
+#endif
+
+
+    // Compile-time identity of a `Timed::mark` point: name and source location, plus a 32-bit
+    // FNV-1a hash of them for export. Declare sites `static constexpr`, the marks refer to them
+    // by address: `static constexpr Timed::MarkSite parsed { "parsed" };`
+    struct MarkSite
+    {
+        std::string_view name;
+        std::source_location location;
+        std::uint32_t id = 0;
+
+        consteval MarkSite(std::string_view name, std::source_location location = std::source_location::current()) noexcept
+            : name(name), location(location), id(hash(name, location))
+        {
+        }
+
+    private:
+        static consteval std::uint32_t hash(std::string_view name, const std::source_location& location) noexcept
+        {
+            std::uint32_t value = 2166136261u;
+            auto mix = [&](char c) { value = (value ^ static_cast<unsigned char>(c)) * 16777619u; };
+            for (const char* c = location.file_name(); *c; ++c) mix(*c);
+            for (std::uint_least32_t line = location.line(); line; line >>= 8) mix(static_cast<char>(line & 0xff));
+            for (char c : name) mix(c);
+            return value;
+        }
+    };
+
+    // Time between two consecutive marks of one thread, named by the marks bounding it.
+    struct MarkInterval
+    {
+        const MarkSite* from = nullptr;
+        const MarkSite* to = nullptr;
+        int64_t start = 0;    // ns on the tsc_clock time line
+        int64_t duration = 0; // ns
+    };
+
+#ifndef TIMED_MARK_CAPACITY
+    #define TIMED_MARK_CAPACITY 16384 // marks kept per thread before the ring wraps
+#endif
+
+    namespace detail
+    {
+        struct MarkEntry
+        {
+            const MarkSite* site;
+            tsc_clock::rep ticks;
+        };
+
+        struct MarkBuffer
+        {
+            MarkEntry* next = nullptr;
+            MarkEntry* end = nullptr;
+            MarkEntry* begin = nullptr;
+            std::uint64_t wraps = 0;
+            std::unique_ptr<MarkEntry[]> storage;
+        };
+
+        // Every thread's ring, registered on its first mark and intentionally leaked like the
+        // Registry so marks survive the thread for a later collection.
+        class MarkRings
+        {
+        private:
+            std::mutex mutex;
+            std::vector<std::unique_ptr<MarkBuffer>> buffers;
+
+        public:
+            static MarkRings& instance() noexcept
+            {
+                static MarkRings* rings = new MarkRings();
+                return *rings;
+            }
+
+            // Full before the first mark, so the hot path needs a single check.
+            static MarkBuffer& empty() noexcept
+            {
+                static MarkBuffer buffer;
+                return buffer;
+            }
+
+            static MarkBuffer*& local() noexcept
+            {
+                thread_local MarkBuffer* buffer = &empty();
+                return buffer;
+            }
+
+            // Slow path of `mark`: allocate the thread's ring on first use, afterwards wrap it.
+            static void wrap(MarkBuffer*& buffer) noexcept
+            {
+                if (buffer == &empty()) {
+                    try {
+                        auto created = std::make_unique<MarkBuffer>();
+                        created->storage = std::make_unique<MarkEntry[]>(TIMED_MARK_CAPACITY);
+                        created->begin = created->next = created->storage.get();
+                        created->end = created->begin + TIMED_MARK_CAPACITY;
+                        MarkRings& rings = instance();
+                        std::lock_guard lock(rings.mutex);
+                        rings.buffers.push_back(std::move(created));
+                        buffer = rings.buffers.back().get();
+                    } catch (...) {
+                        // marks of this thread are dropped into a scratch ring from now on
+                        thread_local std::array<MarkEntry, 64> scratch;
+                        thread_local MarkBuffer fallback;
+                        fallback.begin = scratch.data();
+                        fallback.end = scratch.data() + scratch.size();
+                        buffer = &fallback;
+                    }
+                } else {
+                    ++buffer->wraps;
+                }
+                buffer->next = buffer->begin;
+            }
+
+            template <typename Visit>
+            void for_each(Visit&& visit)
+            {
+                std::lock_guard lock(mutex);
+                for (auto& buffer : buffers) visit(*buffer);
+            }
+        };
+    } // namespace detail
+
+
+    // Records `(site, tsc)` into the calling thread's preallocated ring: one TSC read, one store
+    // and the wrap check, a few ns per point. Intervals are rebuilt later by `Marks::collect()`.
+    inline void mark(const MarkSite& site) noexcept
+    {
+        detail::MarkBuffer*& buffer = detail::MarkRings::local();
+        if (buffer->next == buffer->end) [[unlikely]] detail::MarkRings::wrap(buffer);
+        *buffer->next++ = { &site, tsc_clock::ticks() };
+    }
+
+
+    // Offline pass over the mark rings of every thread. Rings are written without
+    // synchronization, so collect while the marking threads are paused or finished.
+    class Marks
+    {
+    public:
+        // Rebuild the intervals between consecutive marks of each thread, oldest first, and
+        // empty the rings. With `record`, every interval also goes to Timed::Registry, named
+        // "from -> to" (or the site name when both marks are the same site) at the `to` location.
+        static std::vector<MarkInterval> collect(bool record = true)
+        {
+            std::vector<MarkInterval> intervals;
+            std::string name;
+            const double ticks_per_ns = tsc_clock::ticks_per_ns();
+
+            detail::MarkRings::instance().for_each([&](detail::MarkBuffer& buffer) {
+                // after a wrap the oldest surviving mark is the one about to be overwritten
+                const detail::MarkEntry* previous = nullptr;
+                auto visit = [&](const detail::MarkEntry* first, const detail::MarkEntry* last) {
+                    for (const detail::MarkEntry* entry = first; entry != last; ++entry) {
+                        if (previous) {
+                            MarkInterval interval { previous->site, entry->site,
+                                                    tsc_clock::from_ticks(previous->ticks).count(),
+                                                    static_cast<int64_t>(static_cast<double>(entry->ticks - previous->ticks) / ticks_per_ns) };
+                            intervals.push_back(interval);
+                            if (record) {
+                                name.assign(interval.from->name);
+                                if (interval.from != interval.to) name.append(" -> ").append(interval.to->name);
+                                Registry::record(name, interval.to->location, interval.duration);
+                            }
+                        }
+                        previous = entry;
+                    }
+                };
+                if (buffer.wraps) visit(buffer.next, buffer.end);
+                visit(buffer.begin, buffer.next);
+                buffer.next = buffer.begin;
+                buffer.wraps = 0;
+            });
+            return intervals;
+        }
+
+        // Number of marks lost to ring wraps since the last collection, over all threads.
+        static std::uint64_t get_overwritten()
+        {
+            std::uint64_t overwritten = 0;
+            detail::MarkRings::instance().for_each([&](detail::MarkBuffer& buffer) {
+                if (buffer.wraps) overwritten += (buffer.wraps - 1) * TIMED_MARK_CAPACITY + static_cast<std::uint64_t>(buffer.next - buffer.begin);
+            });
+            return overwritten;
+        }
+    };
+
+
+    namespace detail
+    {
+        // Conversions used by the timers at report time, never while measuring.
+        template <typename clock>
+        double to_nanoseconds_f(typename clock::duration elapsed) noexcept
+        {
+            return std::chrono::duration<double, std::nano>(elapsed).count();
+        }
+
+        template <typename clock>
+        int64_t to_nanoseconds(typename clock::duration elapsed) noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+
+        template <typename T>
+        concept Duration = std::is_base_of_v<std::chrono::duration<typename T::rep, typename T::period>, T>
+                        || std::same_as<T, automatic_duration>;
+
+
+        constexpr int64_t ns_in_us = 1000;
+        constexpr int64_t ns_in_ms = ns_in_us * 1000;
+        constexpr int64_t ns_in_s  = ns_in_ms * 1000;
+        constexpr int64_t ns_in_min = 60 * ns_in_s;
+        constexpr int64_t ns_in_hr  = 60 * ns_in_min;
+
+
+
+        // Per-thread heap counters maintained by the TIMED_TRACK_ALLOCATIONS operator new/delete.
+        // Trivial so the thread_local needs no construction inside the allocator.
+        struct AllocationState
+        {
+            std::uint64_t count;
+            std::uint64_t bytes;
+            int64_t live;  // may go negative when memory is freed by another thread
+            int64_t peak;
+        };
+
+        inline AllocationState& allocation_state() noexcept
+        {
+            thread_local AllocationState state {};
+            return state;
+        }
+
+        // Set once the replacement operator new is linked in.
+        inline std::atomic<bool>& allocation_hooks() noexcept
+        {
+            static std::atomic<bool> installed { false };
+            return installed;
+        }
+
+        // Decides 1-in-`every` sampling from thread-local countdowns. Sites are spread over a few
+        // slots so interleaved sites do not starve each other; a collision only blurs the rate.
+        inline bool should_sample(const std::source_location& location, std::uint32_t every) noexcept
+        {
+            if (every <= 1) return true;
+
+            thread_local std::array<std::uint32_t, 64> remaining {};
+            auto slot = ((reinterpret_cast<std::uintptr_t>(location.file_name()) >> 4) ^ (location.line() * 0x9e3779b1u)) & 63;
+            if (remaining[slot] == 0) {
+                remaining[slot] = every - 1;
+                return true;
+            }
+            --remaining[slot];
+            return false;
+        }
+
+        struct BaseTimerSettings
+        {
+            static constexpr Format default_format { "[{filename}:{row} in `{function}` -- {name}] -> {result}" };
+
+            std::string_view name;
+            Format format = default_format;
+            bool show_output = true;
+            std::source_location location = std::source_location::current();
+            std::ostream& output_stream = std::cout;
+            // when set, reports go to the sink instead of being formatted to `output_stream`
+            Sink* sink = nullptr;
+            // aggregate every measurement into Timed::Registry, even when `show_output` is false
+            bool record = false;
+            // also record every measurement into this histogram
+            Histogram* histogram = nullptr;
+            // also record every measurement into this baseline, under `name`
+            Baseline* baseline = nullptr;
+            // only time 1 in `sample_every` invocations of this site on each thread
+            std::uint32_t sample_every = 1;
+            // read Timed::PerfCounters around the measurement, for `{cycles}`, `{ipc}`, ...;
+            // the timer must then start and end on the same thread
+            bool counters = false;
+            // count heap allocations of the thread during the measurement, for `{allocations}`,
+            // `{allocated_bytes}` and `{peak_bytes}`; needs TIMED_TRACK_ALLOCATIONS in one file
+            bool allocations = false;
+            // work done by one call, for `{throughput}` (bytes/s, or items/s when no bytes are
+            // given) and `{ns_per_item}`
+            std::uint64_t bytes = 0;
+            std::uint64_t items = 0;
+
+
+            std::string_view get_name() const noexcept { return name; }
+            std::string_view get_format() const noexcept { return format.str(); }
+            std::string_view get_filename() const noexcept { return location.file_name(); }
+            int get_line() const noexcept { return location.line(); }
+            std::string_view get_function_name() const noexcept { return location.function_name(); }
+        };
+
+        class BaseTimerFormatter
+        {
+        protected:
+            // Large enough for any int64_t count or fixed 6-digit double plus a unit suffix.
+            using DurationBuffer = std::array<char, 64>;
+
+            static std::string_view to_chars(DurationBuffer& buffer, int64_t value, std::string_view suffix) noexcept
+            {
+                auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size() - suffix.size(), value);
+                end = std::copy(suffix.begin(), suffix.end(), end);
+                return std::string_view(buffer.data(), end - buffer.data());
+            }
+
+            static std::string_view to_chars(DurationBuffer& buffer, double value, std::string_view suffix) noexcept
+            {
+                auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size() - suffix.size(), value, std::chars_format::fixed, 6);
+                end = std::copy(suffix.begin(), suffix.end(), end);
+                return std::string_view(buffer.data(), end - buffer.data());
+            }
+
+            static std::string_view automatic_duration_to_chars(DurationBuffer& buffer, int64_t elapsed) noexcept {
+                if (elapsed < ns_in_us) {
+                    return to_chars(buffer, elapsed, " ns");
+                } else if (elapsed < ns_in_ms) {
+                    return to_chars(buffer, elapsed / 1000.0, " us");
+                } else if (elapsed < ns_in_s) {
+                    return to_chars(buffer, elapsed / 1'000'000.0, " ms");
+                } else if (elapsed < ns_in_min) {
+                    return to_chars(buffer, elapsed / 1'000'000'000.0, " s");
+                } else if (elapsed < ns_in_hr) {
+                    return to_chars(buffer, elapsed / 60'000'000'000.0, " m");
+                } else {
+                    return to_chars(buffer, elapsed / 3'600'000'000'000.0, " h");
+                }
+            }
+
+            static const std::string automatic_duration_to_string(int64_t elapsed) noexcept {
+                DurationBuffer buffer;
+                return std::string(automatic_duration_to_chars(buffer, elapsed));
+            }
+
+            template <detail::Duration duration>
+            static constexpr std::string_view duration_suffix() {
+                if constexpr (std::same_as<duration, std::chrono::nanoseconds>) return "ns";
+                else if constexpr (std::same_as<duration, std::chrono::microseconds>) return "us";
+                else if constexpr (std::is_same_v<duration, std::chrono::milliseconds>) return "ms";
+                else if constexpr (std::is_same_v<duration, std::chrono::seconds>) return "s";
+                else if constexpr (std::is_same_v<duration, std::chrono::minutes>) return "m";
+                else if constexpr (std::is_same_v<duration, std::chrono::hours>) return "h";
+                else return "unknown";
+            }
+
+            // Format a nanosecond count in the requested duration, e.g. "3 s" or "1.234000 ms".
+            template <detail::Duration duration>
+            static std::string_view duration_to_chars(DurationBuffer& buffer, int64_t elapsed_ns) noexcept
+            {
+                if constexpr (std::is_same_v<duration, automatic_duration>) {
+                    return automatic_duration_to_chars(buffer, elapsed_ns);
+                } else {
+                    constexpr std::string_view suffix = duration_suffix<duration>();
+                    std::array<char, suffix.size() + 1> unit {' '};
+                    std::copy(suffix.begin(), suffix.end(), unit.begin() + 1);
+                    auto elapsed = std::chrono::duration_cast<duration>(std::chrono::nanoseconds(elapsed_ns)).count();
+                    return to_chars(buffer, static_cast<int64_t>(elapsed), std::string_view(unit.data(), unit.size()));
+                }
+            }
+
+            // Fractional nanoseconds, for per-call times measured over batches, e.g. "2.418 ns".
+            template <detail::Duration duration>
+            static std::string_view duration_to_chars(DurationBuffer& buffer, double elapsed_ns) noexcept
+            {
+                if constexpr (std::is_same_v<duration, automatic_duration>) {
+                    if (elapsed_ns >= ns_in_us) return automatic_duration_to_chars(buffer, static_cast<int64_t>(elapsed_ns));
+                    auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size() - 3, elapsed_ns, std::chars_format::fixed, 3);
+                    end = std::copy_n(" ns", 3, end);
+                    return std::string_view(buffer.data(), end - buffer.data());
+                } else {
+                    constexpr std::string_view suffix = duration_suffix<duration>();
+                    std::array<char, suffix.size() + 1> unit {' '};
+                    std::copy(suffix.begin(), suffix.end(), unit.begin() + 1);
+                    auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, typename duration::period>>(
+                        std::chrono::duration<double, std::nano>(elapsed_ns)).count();
+                    return to_chars(buffer, elapsed, std::string_view(unit.data(), unit.size()));
+                }
+            }
+
+            // Sinks render records with their own format and automatic durations.
+            static Format::Fields record_fields(DurationBuffer& buffer, const Record& record) noexcept
+            {
+                return { record.location.file_name(), record.location.line(), record.name,
+                         record.location.function_name(), automatic_duration_to_chars(buffer, record.get_elapsed()) };
+            }
+
+            template <typename S>
+            requires std::derived_from<S, BaseTimerSettings>
+            static constexpr Format::Fields format_fields(std::string_view result, const S& settings,
+                                                          const Counters* counters = nullptr,
+                                                          const Allocations* allocations = nullptr,
+                                                          const Work* work = nullptr) noexcept
+            {
+                return { settings.get_filename(), static_cast<std::uint_least32_t>(settings.get_line()),
+                         settings.get_name(), settings.get_function_name(), result, counters, allocations, work };
+            }
+
+            // Render into any output iterator in one pass, e.g. straight into a stream buffer.
+            template <typename Out, typename S>
+            requires std::derived_from<S, BaseTimerSettings>
+            Out format_output(Out out, std::string_view result, const S& settings, const Counters* counters = nullptr,
+                              const Allocations* allocations = nullptr, const Work* work = nullptr) const
+            {
+                return settings.format.render(out, format_fields(result, settings, counters, allocations, work));
+            }
+
+            template <typename S>
+            requires std::derived_from<S, BaseTimerSettings>
+            std::string format_output(std::string_view result, S& settings, const Counters* counters = nullptr,
+                                      const Allocations* allocations = nullptr, const Work* work = nullptr) const noexcept
+            {
+                std::string out;
+                format_output(std::back_inserter(out), result, settings, counters, allocations, work);
+                return out;
+            }
+
+            template <typename S>
+            requires std::derived_from<S, BaseTimerSettings>
+            void write_output(std::string_view result, const S& settings, const Counters* counters = nullptr,
+                              const Allocations* allocations = nullptr, const Work* work = nullptr) const noexcept
+            {
+                // no flush per line: the stream's buffer batches reports, and std::cout is flushed at exit
+                format_output(std::ostreambuf_iterator<char>(settings.output_stream), result, settings, counters, allocations, work);
+                settings.output_stream.put('\n');
+            }
+        };
+
+        template <Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+        class BaseTimer : public BaseTimerFormatter
+        {
+        public:
+            using Settings = BaseTimerSettings;
+
+        private:
+            clock::time_point m_start;
+            clock::time_point m_end;
+            Settings settings;
+            bool sampled;
+            bool counting;
+            bool tracking;
+            Counters counters_start;
+            Counters counters;
+            AllocationState allocations_start;
+            Allocations allocations;
+
+        protected:
+            BaseTimer(Settings settings) noexcept
+                : settings(settings), sampled(should_sample(settings.location, settings.sample_every)),
+                  counting(sampled && settings.counters && PerfCounters::local().is_open()),
+                  tracking(sampled && settings.allocations && allocation_hooks().load(std::memory_order_relaxed))
+            {
+            }
+
+            ~BaseTimer() noexcept = default;
+
+            BaseTimer(const BaseTimer&) = delete;
+            BaseTimer& operator=(const BaseTimer&) = delete;
+            BaseTimer(BaseTimer&&) = delete;
+            BaseTimer& operator=(BaseTimer&&) = delete;
+
+            // counters are read outside the clock reads, so their cost stays out of the duration
+            void start_timer() noexcept
+            {
+                if (!sampled) return;
+                if (counting) counters_start = PerfCounters::local().read();
+                if (tracking) {
+                    // the peak is tracked relative to this region, then merged back for enclosing ones
+                    AllocationState& state = allocation_state();
+                    allocations_start = state;
+                    state.peak = state.live;
+                }
+                m_start = clock::now();
+            }
+            void end_timer() noexcept
+            {
+                if (!sampled) return;
+                m_end = clock::now();
+                if (tracking) {
+                    AllocationState& state = allocation_state();
+                    allocations = { state.count - allocations_start.count, state.bytes - allocations_start.bytes,
+                                    static_cast<std::uint64_t>(std::max<int64_t>(state.peak - allocations_start.live, 0)) };
+                    state.peak = std::max(state.peak, allocations_start.peak);
+                }
+                if (counting) counters = PerfCounters::local().read() - counters_start;
+            }
+            void show_result() const noexcept
+            {
+                if (!sampled) return;
+                if (settings.record) Registry::record(settings.name, settings.location, get_elapsed());
+                if (settings.histogram) settings.histogram->record(get_elapsed());
+                if (settings.baseline) settings.baseline->record(settings.name, get_elapsed());
+                if (!settings.show_output) return;
+
+                if (settings.sink) {
+                    settings.sink->write({ settings.name, settings.location,
+                                           to_nanoseconds<clock>(m_start.time_since_epoch()),
+                                           to_nanoseconds<clock>(m_end.time_since_epoch()) });
+                    return;
+                }
+
+                DurationBuffer buffer;
+                Work work = get_work();
+                write_output(duration_to_chars<duration>(buffer, get_elapsed()), settings, get_counters(), get_allocations(), &work);
+            }
+
+
+            [[nodiscard]] const auto get_start() const noexcept { return m_start; }
+            [[nodiscard]] const auto get_end() const noexcept { return m_end; }
+            [[nodiscard]] const auto get_elapsed() const noexcept
+            {
+                return to_nanoseconds<clock>(m_end - m_start);
+            }
+            [[nodiscard]] bool is_sampled() const noexcept { return sampled; }
+            // Hardware counters of the measurement, or null if `Settings::counters` was not set
+            // or the counters are unavailable.
+            [[nodiscard]] const Counters* get_counters() const noexcept { return counting ? &counters : nullptr; }
+            // Heap activity of the measurement, or null if `Settings::allocations` was not set or
+            // TIMED_TRACK_ALLOCATIONS is not defined in any file of the program.
+            [[nodiscard]] const Allocations* get_allocations() const noexcept { return tracking ? &allocations : nullptr; }
+            // The declared bytes and items with the measured time, for throughput.
+            [[nodiscard]] Work get_work() const noexcept
+            {
+                return { settings.bytes, settings.items, static_cast<double>(get_elapsed()) };
+            }
+
+
+        };
+
+
+    } // namespace detail
+
+
+    // Optimizer barriers, the equivalents of google-benchmark's DoNotOptimize/ClobberMemory.
+    // `do_not_optimize` forces `value` to be materialized, and for non-const lvalues makes the
+    // compiler assume it was modified, so inputs cannot be constant-folded across iterations.
+#if defined(__GNUC__) || defined(__clang__)
+    template <typename T>
+    inline void do_not_optimize(const T& value) noexcept
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template <typename T>
+    inline void do_not_optimize(T& value) noexcept
+    {
+        if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void*)) {
+            asm volatile("" : "+m,r"(value) : : "memory");
+        } else {
+            asm volatile("" : "+m"(value) : : "memory");
+        }
+    }
+
+    // Forces all pending memory writes to be considered observable.
+    inline void clobber_memory() noexcept
+    {
+        asm volatile("" : : : "memory");
+    }
+#else
+    namespace detail
+    {
+        inline void use_char_pointer(const volatile char*) noexcept {}
+    }
+
+    template <typename T>
+    inline void do_not_optimize(const T& value) noexcept
+    {
+        detail::use_char_pointer(&reinterpret_cast<const volatile char&>(value));
+        _ReadWriteBarrier();
+    }
+
+    inline void clobber_memory() noexcept
+    {
+        _ReadWriteBarrier();
+    }
+#endif
+
+
+    namespace detail
+    {
+        // In-place, allocation-free storage for a callable's result.
+        // References are stored as pointers and `void` stores nothing.
+        template <typename R>
+        class ResultStorage
+        {
+        private:
+            // Converting to R lets `emplace` construct the result in place from the call.
+            template <typename Producer>
+            struct InPlace
+            {
+                Producer& produce;
+                operator R() { return produce(); }
+            };
+
+            std::optional<R> value;
+
+        public:
+            template <typename Producer>
+            void emplace(Producer&& produce) { value.emplace(InPlace<Producer> { produce }); }
+            void reset() noexcept { value.reset(); }
+
+            [[nodiscard]] bool has_value() const noexcept { return value.has_value(); }
+            [[nodiscard]] const R& get() const noexcept { return *value; }
+            [[nodiscard]] R take() noexcept(std::is_nothrow_move_constructible_v<R>) { return std::move(*value); }
+        };
+
+        template <typename R>
+        class ResultStorage<R&>
+        {
+        private:
+            R* value = nullptr;
+
+        public:
+            template <typename Producer>
+            void emplace(Producer&& produce) { value = &produce(); }
+            void reset() noexcept { value = nullptr; }
+
+            [[nodiscard]] bool has_value() const noexcept { return value != nullptr; }
+            [[nodiscard]] R& get() const noexcept { return *value; }
+            [[nodiscard]] R& take() const noexcept { return *value; }
+        };
+
+        template <>
+        class ResultStorage<void>
+        {
+        public:
+            template <typename Producer>
+            void emplace(Producer&& produce) { produce(); }
+            void reset() noexcept {}
+
+            [[nodiscard]] bool has_value() const noexcept { return false; }
+        };
+    } // namespace detail
+
+
+    // Times a single call. The result type is deduced from the callable: `FunctionTimer({"f"}, f, 1)`.
+#if TIMED_ENABLED
+    template <typename R, detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class FunctionTimer : public detail::BaseTimer<duration, clock>
+    {
+    public:
+        using Base = detail::BaseTimer<duration, clock>;
+        using Settings = Base::Settings;
+        using Result = R;
+
+    private:
+        detail::ResultStorage<R> fresult;
+
+    public:
+        FunctionTimer(const FunctionTimer&) = delete;
+        FunctionTimer& operator=(const FunctionTimer&) = delete;
+        FunctionTimer(FunctionTimer&&) = delete;
+        FunctionTimer& operator=(FunctionTimer&&) = delete;
+
+        template <typename Callable, typename... Args>
+        FunctionTimer(Settings settings, Callable&& function, Args&&... args) noexcept : Base(settings)
+        {
+            auto call = [&]() -> R { return std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...); };
+            this->start_timer();
+            fresult.emplace(call);
+            this->end_timer();
+        }
+
+        ~FunctionTimer() noexcept
+        {
+            this->show_result();
+        }
+
+        [[nodiscard]] decltype(auto) get_result() const noexcept requires (!std::is_void_v<R>)
+        {
+            return fresult.get();
+        }
+
+        // Moves the result out of the timer; valid once.
+        [[nodiscard]] decltype(auto) take_result() requires (!std::is_void_v<R>)
+        {
+            return fresult.take();
+        }
+
+        using Base::get_elapsed;
+        using Base::is_sampled;
+        using Base::get_counters;
+        using Base::get_allocations;
+        using Base::get_work;
+    };
+#else
+    template <typename R, detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class FunctionTimer
+    {
+    public:
+        using Settings = detail::BaseTimerSettings;
+        using Result = R;
+
+    private:
+        detail::ResultStorage<R> fresult;
+
+    public:
+        FunctionTimer(const FunctionTimer&) = delete;
+        FunctionTimer& operator=(const FunctionTimer&) = delete;
+        FunctionTimer(FunctionTimer&&) = delete;
+        FunctionTimer& operator=(FunctionTimer&&) = delete;
+
+        template <typename Callable, typename... Args>
+        FunctionTimer(Settings, Callable&& function, Args&&... args) noexcept
+        {
+            fresult.emplace([&]() -> R { return std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...); });
+        }
+
+        [[nodiscard]] decltype(auto) get_result() const noexcept requires (!std::is_void_v<R>) { return fresult.get(); }
+        [[nodiscard]] decltype(auto) take_result() requires (!std::is_void_v<R>) { return fresult.take(); }
+
+        [[nodiscard]] constexpr int64_t get_elapsed() const noexcept { return 0; }
+        [[nodiscard]] constexpr bool is_sampled() const noexcept { return false; }
+        [[nodiscard]] constexpr const Counters* get_counters() const noexcept { return nullptr; }
+        [[nodiscard]] constexpr const Allocations* get_allocations() const noexcept { return nullptr; }
+        [[nodiscard]] constexpr Work get_work() const noexcept { return {}; }
+    };
+#endif
+
+    template <typename Callable, typename... Args>
+    FunctionTimer(detail::BaseTimerSettings, Callable&&, Args&&...) -> FunctionTimer<std::invoke_result_t<Callable, Args...>>;
+
+
+    namespace detail
+    {
+        // Welford's running mean and variance, plus min/max/total.
+        class RunningMoments
+        {
+        private:
+            std::size_t n = 0;
+            double running_mean = 0;
+            double m2 = 0;
+            int64_t lowest = std::numeric_limits<int64_t>::max();
+            int64_t highest = std::numeric_limits<int64_t>::min();
+            int64_t sum = 0;
+
+        public:
+            void add(int64_t sample) noexcept
+            {
+                ++n;
+                double delta = static_cast<double>(sample) - running_mean;
+                running_mean += delta / static_cast<double>(n);
+                m2 += delta * (static_cast<double>(sample) - running_mean);
+                lowest = std::min(lowest, sample);
+                highest = std::max(highest, sample);
+                sum += sample;
+            }
+
+            [[nodiscard]] std::size_t count() const noexcept { return n; }
+            [[nodiscard]] int64_t total() const noexcept { return sum; }
+            [[nodiscard]] int64_t min() const noexcept { return lowest; }
+            [[nodiscard]] int64_t max() const noexcept { return highest; }
+            [[nodiscard]] double mean() const noexcept { return running_mean; }
+            // sample variance, in ns^2
+            [[nodiscard]] double variance() const noexcept { return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0; }
+            [[nodiscard]] double stddev() const noexcept { return std::sqrt(variance()); }
+        };
+
+        template <typename T>
+        concept Statistics = requires(T stats, const T cstats, int64_t sample, std::size_t n, double quantile) {
+            stats.reserve(n);
+            stats.add(sample);
+            { cstats.count() } -> std::convertible_to<std::size_t>;
+            { cstats.total() } -> std::convertible_to<int64_t>;
+            { cstats.min() } -> std::convertible_to<int64_t>;
+            { cstats.max() } -> std::convertible_to<int64_t>;
+            { cstats.mean() } -> std::convertible_to<double>;
+            { cstats.variance() } -> std::convertible_to<double>;
+            { cstats.percentile(quantile) } -> std::convertible_to<int64_t>;
+        };
+    } // namespace detail
+
+
+    // Tukey-fence classification of samples: mild outliers lie beyond 1.5 IQR of the
+    // quartiles, severe ones beyond 3 IQR. Fences are in nanoseconds, like the samples.
+    struct Outliers
+    {
+        std::size_t low_severe = 0;
+        std::size_t low_mild = 0;
+        std::size_t high_mild = 0;
+        std::size_t high_severe = 0;
+        double lower_fence = 0; // mild fences
+        double upper_fence = 0;
+
+        [[nodiscard]] constexpr std::size_t total() const noexcept { return low_severe + low_mild + high_mild + high_severe; }
+    };
+
+
+    // Keeps every sample on the heap; order statistics are exact, using `std::nth_element`.
+    // Also provides robust estimators that one preempted iteration cannot skew.
+    class ExactStatistics : public detail::RunningMoments
+    {
+    private:
+        mutable std::vector<int64_t> samples;
+
+    public:
+        void reserve(std::size_t n) { samples.reserve(n); }
+        void add(int64_t sample)
+        {
+            RunningMoments::add(sample);
+            samples.push_back(sample);
+        }
+
+        // Linearly interpolated quantile in [0, 1], e.g. 0.5 for the median.
+        [[nodiscard]] int64_t percentile(double quantile) const noexcept
+        {
+            if (samples.empty()) return 0;
+
+            double rank = std::clamp(quantile, 0.0, 1.0) * static_cast<double>(samples.size() - 1);
+            auto lower = static_cast<std::size_t>(rank);
+            std::nth_element(samples.begin(), samples.begin() + lower, samples.end());
+            int64_t value = samples[lower];
+            if (lower + 1 == samples.size() || rank == static_cast<double>(lower)) return value;
+
+            // after nth_element the next order statistic is the smallest of the upper part
+            int64_t next = *std::min_element(samples.begin() + lower + 1, samples.end());
+            return value + static_cast<int64_t>((rank - static_cast<double>(lower)) * static_cast<double>(next - value));
+        }
+
+        // Median absolute deviation from the median; times 1.4826 it estimates the standard
+        // deviation of normally distributed samples.
+        [[nodiscard]] double mad() const
+        {
+            if (samples.empty()) return 0;
+            const double median = static_cast<double>(percentile(0.5));
+            std::vector<double> deviations;
+            deviations.reserve(samples.size());
+            for (int64_t sample : samples) deviations.push_back(std::abs(static_cast<double>(sample) - median));
+            auto middle = deviations.begin() + static_cast<std::ptrdiff_t>(deviations.size() / 2);
+            std::nth_element(deviations.begin(), middle, deviations.end());
+            if (deviations.size() % 2) return *middle;
+            return (*middle + *std::max_element(deviations.begin(), middle)) / 2;
+        }
+
+        // Mean of the samples left after dropping `fraction` of them at each end, e.g. 0.1
+        // ignores the fastest and slowest 10%.
+        [[nodiscard]] double trimmed_mean(double fraction = 0.1) const noexcept
+        {
+            if (samples.empty()) return 0;
+            std::sort(samples.begin(), samples.end());
+            auto cut = static_cast<std::size_t>(std::clamp(fraction, 0.0, 0.5) * static_cast<double>(samples.size()));
+            if (2 * cut >= samples.size()) cut = (samples.size() - 1) / 2;
+            double sum = 0;
+            for (std::size_t i = cut; i < samples.size() - cut; ++i) sum += static_cast<double>(samples[i]);
+            return sum / static_cast<double>(samples.size() - 2 * cut);
+        }
+
+        [[nodiscard]] Outliers outliers() const noexcept
+        {
+            Outliers result;
+            if (samples.empty()) return result;
+            const auto q1 = static_cast<double>(percentile(0.25));
+            const auto q3 = static_cast<double>(percentile(0.75));
+            const double iqr = q3 - q1;
+            result.lower_fence = q1 - 1.5 * iqr;
+            result.upper_fence = q3 + 1.5 * iqr;
+            for (int64_t sample : samples) {
+                auto value = static_cast<double>(sample);
+                if (value < q1 - 3 * iqr) ++result.low_severe;
+                else if (value < result.lower_fence) ++result.low_mild;
+                else if (value > q3 + 3 * iqr) ++result.high_severe;
+                else if (value > result.upper_fence) ++result.high_mild;
+            }
+            return result;
+        }
+
+        [[nodiscard]] const std::vector<int64_t>& get_samples() const noexcept { return samples; }
+    };
+
+
+    // Constant memory whatever the number of samples: Welford moments plus a log-linear
+    // histogram for quantiles, accurate to within 1% of the value.
+    class StreamingStatistics : public detail::RunningMoments
+    {
+    private:
+        Histogram::Snapshot histogram;
+
+    public:
+        void reserve(std::size_t) noexcept {}
+        void add(int64_t sample) noexcept
+        {
+            RunningMoments::add(sample);
+            histogram.record(sample);
+        }
+
+        [[nodiscard]] int64_t percentile(double quantile) const noexcept { return histogram.get_percentile(quantile); }
+        [[nodiscard]] const Histogram::Snapshot& get_histogram() const noexcept { return histogram; }
+    };
+
+
+    namespace detail
+    {
+        struct NoSetup
+        {
+            constexpr void operator()() const noexcept {}
+        };
+
+        struct NoTeardown
+        {
+            template <typename... T>
+            constexpr void operator()(T&&...) const noexcept {}
+        };
+
+        // How an argument reaches each iteration: lvalues by reference, rvalues as a fresh copy
+        // made outside the timed window (moved into the call), or by reference if not copyable.
+        template <typename Arg>
+        using IterationArgument = std::conditional_t<std::is_lvalue_reference_v<Arg> || !std::is_copy_constructible_v<std::decay_t<Arg>>,
+                                                     std::decay_t<Arg>&, std::decay_t<Arg>>;
+    } // namespace detail
+
+
+    // Per-iteration setup and teardown for AverageFunctionTimer, run outside the timed window.
+    // When `setup` returns a value, it is passed to the callable before the other arguments (as
+    // an rvalue when the callable accepts one) and then to `teardown`:
+    //     Timed::Fixture { [] { return make_input(); }, [](auto& input) { ... } }
+    template <typename Setup = detail::NoSetup, typename Teardown = detail::NoTeardown>
+    struct Fixture
+    {
+        Setup setup {};
+        Teardown teardown {};
+    };
+
+    template <typename Setup>
+    Fixture(Setup) -> Fixture<Setup, detail::NoTeardown>;
+
+    template <typename Setup, typename Teardown>
+    Fixture(Setup, Teardown) -> Fixture<Setup, Teardown>;
+
+
+    // Times `Settings::iterations` calls and reports their average. `Statistics` selects how
+    // samples are summarized (ExactStatistics or StreamingStatistics); `R` is the type of the
+    // result kept from the last call, `void` keeps none.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock,
+              detail::Statistics Statistics = ExactStatistics, typename R = void>
+    class AverageFunctionTimer : public detail::BaseTimerFormatter
+    {
+
+
+    public:
+        template <typename Result>
+        using ChildTimer = FunctionTimer<Result, duration, clock>;
+        using ChildSettings = detail::BaseTimerSettings;
+
+        struct Settings: public ChildSettings
+        {
+            std::size_t iterations = 10;
+            bool child_output = false;
+            // Adaptive mode, when above 0: after `iterations` calls, keep sampling until the 95%
+            // confidence interval of the mean is within +/- `target_precision` of it (e.g. 0.01
+            // for 1%), `time_budget` has elapsed or `max_iterations` calls were made.
+            double target_precision = 0;
+            std::chrono::nanoseconds time_budget = std::chrono::seconds(1);
+            std::size_t max_iterations = 1'000'000;
+
+            // Constructor for the child timer
+            ChildSettings get_settings_t() const
+            {
+                ChildSettings settings = *this;
+                settings.show_output = child_output;
+                settings.sample_every = 1;
+                return settings;
+            }
+        };
+
+    private:
+            Statistics stats;
+            detail::ResultStorage<R> fresult;
+            Settings settings;
+            Counters counters;
+            bool counting = false;
+            Allocations allocations;
+            bool tracking = false;
+
+            template <typename Callable, typename... CallArgs>
+            void time_iteration(bool last, const ChildSettings& timer_settings, Callable& function, CallArgs&&... args)
+            {
+                using CallResult = std::invoke_result_t<Callable&, CallArgs...>;
+                static_assert(std::is_void_v<R> || std::is_convertible_v<CallResult, R>,
+                              "the kept result type must be constructible from the callable's result");
+
+                ChildTimer<CallResult> timer(timer_settings, function, std::forward<CallArgs>(args)...);
+                stats.add(timer.get_elapsed());
+                if (const Counters* measured = timer.get_counters()) {
+                    counters += *measured;
+                    counting = true;
+                }
+                if (const Allocations* measured = timer.get_allocations()) {
+                    allocations += *measured;
+                    tracking = true;
+                }
+                if constexpr (!std::is_void_v<R>) {
+                    if (last) fresult.emplace([&]() -> R { return timer.take_result(); });
+                } else if constexpr (!std::is_void_v<CallResult>) {
+                    do_not_optimize(timer.get_result());
+                }
+            }
+
+    public:
+        AverageFunctionTimer(const AverageFunctionTimer&) = delete;
+        AverageFunctionTimer& operator=(const AverageFunctionTimer&) = delete;
+        AverageFunctionTimer(AverageFunctionTimer&&) = delete;
+        AverageFunctionTimer& operator=(AverageFunctionTimer&&) = delete;
+
+        // Every iteration sees the same arguments: rvalues are copied afresh for each call, so a
+        // call consuming its argument never leaves the next one an emptied object.
+        template <typename Callable, typename... Args>
+        AverageFunctionTimer(Settings settings, Callable&& function, Args&&... args)
+            : AverageFunctionTimer(settings, Fixture {}, std::forward<Callable>(function), std::forward<Args>(args)...)
+        {
+        }
+
+        template <typename Setup, typename Teardown, typename Callable, typename... Args>
+        AverageFunctionTimer(Settings settings, Fixture<Setup, Teardown> fixture, Callable&& function, Args&&... args) : settings(settings)
+        {
+            const std::size_t iterations = std::max<std::size_t>(this->settings.iterations, 1);
+            const bool adaptive = this->settings.target_precision > 0;
+            const std::size_t limit = adaptive ? std::max(this->settings.max_iterations, iterations) : iterations;
+            // elapsed time is compared in nanoseconds, whatever the period of the clock
+            const auto start = clock::now();
+            const int64_t budget = this->settings.time_budget.count();
+            stats.reserve(iterations);
+
+            const ChildSettings timer_settings = this->settings.get_settings_t();
+            for (size_t i = 0; i < limit; ++i) {
+                if (adaptive && i >= iterations && (get_relative_error() <= this->settings.target_precision
+                                                    || detail::to_nanoseconds<clock>(clock::now() - start) >= budget)) break;
+                // the adaptive mode cannot tell which call is the last, so it keeps every result
+                const bool last = adaptive || i + 1 == limit;
+                std::tuple<detail::IterationArgument<Args>...> fresh(args...);
+
+                if constexpr (std::is_void_v<std::invoke_result_t<Setup&>>) {
+                    std::invoke(fixture.setup);
+                    std::apply([&](auto&&... call_args) {
+                        time_iteration(last, timer_settings, function, std::forward<decltype(call_args)>(call_args)...);
+                    }, std::move(fresh));
+                    std::invoke(fixture.teardown);
+                } else {
+                    auto input = std::invoke(fixture.setup);
+                    using Input = decltype(input);
+                    if constexpr (std::is_invocable_v<Callable&, Input&&, detail::IterationArgument<Args>&&...>) {
+                        std::apply([&](auto&&... call_args) {
+                            time_iteration(last, timer_settings, function, std::move(input), std::forward<decltype(call_args)>(call_args)...);
+                        }, std::move(fresh));
+                    } else {
+                        std::apply([&](auto&&... call_args) {
+                            time_iteration(last, timer_settings, function, input, std::forward<decltype(call_args)>(call_args)...);
+                        }, std::move(fresh));
+                    }
+                    std::invoke(fixture.teardown, input);
+                }
+            }
+        }
+
+        ~AverageFunctionTimer()
+        {
+            if (!settings.show_output) return;
+
+            // aggregated reports are handed to sinks as the interval [0, average]
+            if (settings.sink) {
+                settings.sink->write({ settings.name, settings.location, 0, get_average_time() });
+                return;
+            }
+
+            DurationBuffer buffer;
+            Counters average = counters.per_op(stats.count());
+            Allocations allocated = allocations.per_op(stats.count());
+            Work work = get_work();
+            write_output(duration_to_chars<duration>(buffer, get_average_time()), settings,
+                         counting ? &average : nullptr, tracking ? &allocated : nullptr, &work);
+        }
+
+        // Result of the last call, when `R` is not void.
+        [[nodiscard]] decltype(auto) get_result() const noexcept requires (!std::is_void_v<R>)
+        {
+            return fresult.get();
+        }
+
+        // All times are in nanoseconds.
+        [[nodiscard]] const auto get_max_time() const noexcept { return stats.max(); }
+        [[nodiscard]] const auto get_min_time() const noexcept { return stats.min(); }
+        [[nodiscard]] const auto get_median_time() const noexcept { return stats.percentile(0.5); }
+        [[nodiscard]] const auto get_total_time() const noexcept { return stats.total(); }
+        [[nodiscard]] const auto get_average_time() const noexcept
+        {
+            return stats.total() / static_cast<int64_t>(stats.count());
+        }
+        [[nodiscard]] const auto get_variance() const noexcept { return stats.variance(); }
+        [[nodiscard]] const auto get_stddev() const noexcept { return std::sqrt(stats.variance()); }
+        [[nodiscard]] const auto get_percentile(double quantile) const noexcept { return stats.percentile(quantile); }
+        [[nodiscard]] const auto get_iterations() const noexcept { return stats.count(); }
+        // Half-width of the 95% confidence interval of the mean, relative to the mean.
+        [[nodiscard]] double get_relative_error() const noexcept
+        {
+            if (stats.count() < 2 || stats.mean() <= 0) return std::numeric_limits<double>::infinity();
+            return 1.96 * std::sqrt(stats.variance() / static_cast<double>(stats.count())) / stats.mean();
+        }
+        // Robust estimators, with ExactStatistics.
+        [[nodiscard]] double get_mad() const requires requires (const Statistics& s) { s.mad(); } { return stats.mad(); }
+        [[nodiscard]] double get_trimmed_mean(double fraction = 0.1) const noexcept requires requires (const Statistics& s) { s.trimmed_mean(0.1); }
+        {
+            return stats.trimmed_mean(fraction);
+        }
+        [[nodiscard]] Outliers get_outliers() const noexcept requires requires (const Statistics& s) { s.outliers(); } { return stats.outliers(); }
+        // The declared bytes and items of one call with the mean time per call, for throughput.
+        [[nodiscard]] Work get_work() const noexcept
+        {
+            return { settings.bytes, settings.items, stats.count() ? static_cast<double>(stats.total()) / static_cast<double>(stats.count()) : 0.0 };
+        }
+        [[nodiscard]] const Statistics& get_statistics() const noexcept { return stats; }
+        // Hardware counters summed over all calls, or null when not measured; see Counters::per_op.
+        [[nodiscard]] const Counters* get_counters() const noexcept { return counting ? &counters : nullptr; }
+        // Heap activity summed over all calls (peak: the highest of any call), or null when not tracked.
+        [[nodiscard]] const Allocations* get_allocations() const noexcept { return tracking ? &allocations : nullptr; }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock,
+              detail::Statistics Statistics = ExactStatistics, typename R = void>
+    class AverageFunctionTimer
+    {
+    public:
+        template <typename Result>
+        using ChildTimer = FunctionTimer<Result, duration, clock>;
+        using ChildSettings = detail::BaseTimerSettings;
+
+        struct Settings: public ChildSettings
+        {
+            std::size_t iterations = 10;
+            bool child_output = false;
+            double target_precision = 0;
+            std::chrono::nanoseconds time_budget = std::chrono::seconds(1);
+            std::size_t max_iterations = 1'000'000;
+
+            ChildSettings get_settings_t() const { return *this; }
+        };
+
+    private:
+        Statistics stats;
+        detail::ResultStorage<R> fresult;
+
+    public:
+        AverageFunctionTimer(const AverageFunctionTimer&) = delete;
+        AverageFunctionTimer& operator=(const AverageFunctionTimer&) = delete;
+        AverageFunctionTimer(AverageFunctionTimer&&) = delete;
+        AverageFunctionTimer& operator=(AverageFunctionTimer&&) = delete;
+
+        // calls the function once, so side effects and the kept result are preserved
+        template <typename Callable, typename... Args>
+        AverageFunctionTimer(Settings, Callable&& function, Args&&... args)
+        {
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...);
+            } else {
+                fresult.emplace([&]() -> R { return std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...); });
+            }
+        }
+
+        // runs the fixture around a single call
+        template <typename Setup, typename Teardown, typename Callable, typename... Args>
+        AverageFunctionTimer(Settings settings, Fixture<Setup, Teardown> fixture, Callable&& function, Args&&... args)
+        {
+            if constexpr (std::is_void_v<std::invoke_result_t<Setup&>>) {
+                std::invoke(fixture.setup);
+                AverageFunctionTimer once(settings, std::forward<Callable>(function), std::forward<Args>(args)...);
+                fresult = std::move(once.fresult);
+                std::invoke(fixture.teardown);
+            } else {
+                auto input = std::invoke(fixture.setup);
+                if constexpr (std::is_invocable_v<Callable&, decltype(input)&&, Args...>) {
+                    AverageFunctionTimer once(settings, std::forward<Callable>(function), std::move(input), std::forward<Args>(args)...);
+                    fresult = std::move(once.fresult);
+                } else {
+                    AverageFunctionTimer once(settings, std::forward<Callable>(function), input, std::forward<Args>(args)...);
+                    fresult = std::move(once.fresult);
+                }
+                std::invoke(fixture.teardown, input);
+            }
+        }
+
+        [[nodiscard]] decltype(auto) get_result() const noexcept requires (!std::is_void_v<R>) { return fresult.get(); }
+
+        [[nodiscard]] constexpr int64_t get_max_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_min_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_median_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_total_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_average_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_variance() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_stddev() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_percentile(double) const noexcept { return 0; }
+        [[nodiscard]] constexpr std::size_t get_iterations() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_relative_error() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_mad() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_trimmed_mean(double = 0.1) const noexcept { return 0; }
+        [[nodiscard]] constexpr Outliers get_outliers() const noexcept { return {}; }
+        [[nodiscard]] constexpr Work get_work() const noexcept { return {}; }
+        [[nodiscard]] const Statistics& get_statistics() const noexcept { return stats; }
+        [[nodiscard]] constexpr const Counters* get_counters() const noexcept { return nullptr; }
+        [[nodiscard]] constexpr const Allocations* get_allocations() const noexcept { return nullptr; }
+    };
+#endif
+
+
+    // A byte range whose cache lines CacheFlusher::flush evicts, e.g. a benchmark's input.
+    struct MemoryRange
+    {
+        const void* data = nullptr;
+        std::size_t size = 0; // bytes
+
+        MemoryRange(const void* data, std::size_t size) noexcept : data(data), size(size) {}
+
+        template <std::ranges::contiguous_range Range>
+        MemoryRange(const Range& range) noexcept
+            : data(std::ranges::data(range)), size(std::ranges::size(range) * sizeof(std::ranges::range_value_t<Range>)) {}
+    };
+
+
+    // Puts the caches in a cold state: `evict()` streams through a buffer twice the size of the
+    // last-level cache, writing every line so dirty data is pushed out too; `flush()` evicts
+    // given ranges with CLFLUSH (DC CIVAC on AArch64), far cheaper when the inputs are known.
+    class CacheFlusher
+    {
+    private:
+        static constexpr std::size_t line_size = 64;
+        std::unique_ptr<char[]> buffer;
+        std::size_t size;
+
+    public:
+        // `bytes` of 0 uses twice the detected last-level cache size.
+        explicit CacheFlusher(std::size_t bytes = 0) : size(bytes ? bytes : 2 * llc_size())
+        {
+            buffer = std::make_unique<char[]>(size);
+        }
+
+        // Size of the last-level cache in bytes; 32 MiB when it cannot be detected.
+        static std::size_t llc_size() noexcept
+        {
+            static const std::size_t cached = [] {
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+                if (long bytes = sysconf(_SC_LEVEL3_CACHE_SIZE); bytes > 0) return static_cast<std::size_t>(bytes);
+#endif
+#if defined(__linux__)
+                std::ifstream file("/sys/devices/system/cpu/cpu0/cache/index3/size");
+                std::size_t value = 0;
+                char unit = 0;
+                if (file >> value) {
+                    file >> unit;
+                    if (unit == 'K') value <<= 10;
+                    else if (unit == 'M') value <<= 20;
+                    if (value) return value;
+                }
+#endif
+                return std::size_t(32) << 20;
+            }();
+            return cached;
+        }
+
+        void evict() noexcept
+        {
+            for (std::size_t i = 0; i < size; i += line_size) buffer[i] = static_cast<char>(buffer[i] + 1);
+            do_not_optimize(buffer[size - 1]);
+            clobber_memory();
+        }
+
+        static void flush(const MemoryRange& range) noexcept
+        {
+            auto begin = reinterpret_cast<std::uintptr_t>(range.data) & ~(std::uintptr_t(line_size) - 1);
+            auto end = reinterpret_cast<std::uintptr_t>(range.data) + range.size;
+            for (std::uintptr_t line = begin; line < end; line += line_size) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+                asm volatile("clflush (%0)" : : "r"(line) : "memory");
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+                asm volatile("dc civac, %0" : : "r"(line) : "memory");
+#endif
+            }
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            asm volatile("mfence" : : : "memory");
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+            asm volatile("dsb ish" : : : "memory");
+#endif
+        }
+
+        [[nodiscard]] std::size_t get_size() const noexcept { return size; }
+    };
+
+
+    // Hot and cold latency of the same callable, side by side. The hot run warms up with one call
+    // and then times `iterations` calls back to back; the cold run evicts the caches before every
+    // call, outside the timed window: the listed `ranges` with CLFLUSH when given, otherwise by
+    // streaming an LLC-sized buffer. Times are medians, as eviction adds outliers. The `record`,
+    // `histogram` and `baseline` settings are ignored, as they would mix the warm-up, hot and cold
+    // calls; use `get_hot_statistics()` and `get_cold_statistics()`.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class CacheBenchmark : public detail::BaseTimerFormatter
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t iterations = 10;
+            std::vector<MemoryRange> ranges;  // inputs to flush; empty streams through the LLC instead
+            std::size_t eviction_bytes = 0;   // streamed buffer size, 0 for twice the LLC
+        };
+
+    private:
+        using Timer = AverageFunctionTimer<duration, clock>;
+
+        Settings settings;
+        ExactStatistics hot;
+        ExactStatistics cold;
+
+    public:
+        CacheBenchmark(const CacheBenchmark&) = delete;
+        CacheBenchmark& operator=(const CacheBenchmark&) = delete;
+        CacheBenchmark(CacheBenchmark&&) = delete;
+        CacheBenchmark& operator=(CacheBenchmark&&) = delete;
+
+        // Arguments are forwarded to both runs: AverageFunctionTimer copies rvalues for every
+        // call and never moves from the originals.
+        template <typename Callable, typename... Args>
+        CacheBenchmark(Settings settings, Callable&& function, Args&&... args) : settings(std::move(settings))
+        {
+            // one destination cannot tell hot from cold, so the timers do not feed any
+            typename Timer::Settings run_settings { this->settings, this->settings.iterations };
+            run_settings.show_output = false;
+            run_settings.record = false;
+            run_settings.histogram = nullptr;
+            run_settings.baseline = nullptr;
+
+            typename Timer::Settings warmup_settings = run_settings;
+            warmup_settings.iterations = 1;
+            { Timer warmup(warmup_settings, function, std::forward<Args>(args)...); }
+            {
+                Timer timer(run_settings, function, std::forward<Args>(args)...);
+                hot = timer.get_statistics();
+            }
+
+            std::optional<CacheFlusher> flusher;
+            if (this->settings.ranges.empty()) flusher.emplace(this->settings.eviction_bytes);
+            auto evict = [&] {
+                if (flusher) flusher->evict();
+                else for (const MemoryRange& range : this->settings.ranges) CacheFlusher::flush(range);
+            };
+            Timer timer(run_settings, Fixture { evict }, function, std::forward<Args>(args)...);
+            cold = timer.get_statistics();
+        }
+
+        ~CacheBenchmark()
+        {
+            if (!settings.show_output) return;
+
+            DurationBuffer buffer;
+            std::string result = "hot ";
+            result += duration_to_chars<duration>(buffer, get_hot_time());
+            result += ", cold ";
+            result += duration_to_chars<duration>(buffer, get_cold_time());
+            auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), get_cold_ratio(), std::chars_format::fixed, 2);
+            result.append(" (").append(buffer.data(), end).append("x)");
+            write_output(result, settings);
+        }
+
+        // Median times in nanoseconds.
+        [[nodiscard]] int64_t get_hot_time() const noexcept { return hot.percentile(0.5); }
+        [[nodiscard]] int64_t get_cold_time() const noexcept { return cold.percentile(0.5); }
+        // cold / hot: how much the callable depends on cached data.
+        [[nodiscard]] double get_cold_ratio() const noexcept
+        {
+            return get_hot_time() > 0 ? static_cast<double>(get_cold_time()) / static_cast<double>(get_hot_time()) : 0.0;
+        }
+        [[nodiscard]] const ExactStatistics& get_hot_statistics() const noexcept { return hot; }
+        [[nodiscard]] const ExactStatistics& get_cold_statistics() const noexcept { return cold; }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class CacheBenchmark
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t iterations = 10;
+            std::vector<MemoryRange> ranges;
+            std::size_t eviction_bytes = 0;
+        };
+
+    private:
+        ExactStatistics statistics;
+
+    public:
+        CacheBenchmark(const CacheBenchmark&) = delete;
+        CacheBenchmark& operator=(const CacheBenchmark&) = delete;
+        CacheBenchmark(CacheBenchmark&&) = delete;
+        CacheBenchmark& operator=(CacheBenchmark&&) = delete;
+
+        // calls the function once, so side effects are preserved
+        template <typename Callable, typename... Args>
+        CacheBenchmark(Settings, Callable&& function, Args&&... args)
+        {
+            std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] constexpr int64_t get_hot_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_cold_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_cold_ratio() const noexcept { return 0; }
+        [[nodiscard]] const ExactStatistics& get_hot_statistics() const noexcept { return statistics; }
+        [[nodiscard]] const ExactStatistics& get_cold_statistics() const noexcept { return statistics; }
+    };
+#endif
+
+
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class BlockTimer : public detail::BaseTimer<duration, clock>
+    {
+    public:
+        using Base = detail::BaseTimer<duration, clock>;
+        using Settings = typename Base::Settings;
+
+        BlockTimer(const BlockTimer&) = delete;
+        BlockTimer& operator=(const BlockTimer&) = delete;
+        BlockTimer(BlockTimer&&) = delete;
+        BlockTimer& operator=(BlockTimer&&) = delete;
+
+        BlockTimer(Settings settings) noexcept : Base(settings)
+        {
+            this->start_timer();
+        }
+        ~BlockTimer() noexcept = default;
+
+        void end() noexcept
+        {
+            this->end_timer();
+        }
+
+
+        void end_and_show_result() noexcept
+        {
+            this->end_timer();
+            this->show_result();
+        }
+
+        using Base::show_result;
+        using Base::get_elapsed;
+        using Base::is_sampled;
+        using Base::get_counters;
+        using Base::get_allocations;
+        using Base::get_work;
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class BlockTimer
+    {
+    public:
+        using Settings = detail::BaseTimerSettings;
+
+        BlockTimer(const BlockTimer&) = delete;
+        BlockTimer& operator=(const BlockTimer&) = delete;
+        BlockTimer(BlockTimer&&) = delete;
+        BlockTimer& operator=(BlockTimer&&) = delete;
+
+        constexpr BlockTimer(Settings) noexcept {}
+
+        constexpr void end() noexcept {}
+        constexpr void end_and_show_result() noexcept {}
+        constexpr void show_result() const noexcept {}
+        [[nodiscard]] constexpr int64_t get_elapsed() const noexcept { return 0; }
+        [[nodiscard]] constexpr bool is_sampled() const noexcept { return false; }
+        [[nodiscard]] constexpr const Counters* get_counters() const noexcept { return nullptr; }
+        [[nodiscard]] constexpr const Allocations* get_allocations() const noexcept { return nullptr; }
+        [[nodiscard]] constexpr Work get_work() const noexcept { return {}; }
+    };
+#endif
+
+
+    // Per-thread call trees built by nested ProfileTimer scopes, keyed by call path
+    // (source location and name of every enclosing scope) and merged across threads on demand.
+    class Profiler : protected detail::BaseTimerFormatter
+    {
+    public:
+        // Merged view of one call path. Times are in nanoseconds.
+        struct Node
+        {
+            std::string_view name;
+            std::source_location location;
+            std::uint64_t calls = 0;
+            int64_t inclusive = 0; // including children
+            int64_t self = 0;      // excluding children
+            std::vector<Node> children;
+        };
+
+    private:
+        struct ThreadNode
+        {
+            std::string name;
+            std::source_location location;
+            ThreadNode* parent = nullptr;
+            std::atomic<std::uint64_t> calls { 0 };
+            std::atomic<int64_t> inclusive { 0 };
+            // only the owning thread appends, under Tree::mutex; reports read under it
+            std::vector<std::unique_ptr<ThreadNode>> children;
+        };
+
+        struct Tree
+        {
+            std::mutex mutex;
+            ThreadNode root;
+            ThreadNode* current = &root;
+        };
+
+        std::mutex mutex;
+        // shared so a thread's tree outlives the thread until the next report
+        std::vector<std::shared_ptr<Tree>> trees;
+
+        Profiler() = default;
+
+        // Intentionally leaked, like Registry.
+        static Profiler& instance() noexcept
+        {
+            static Profiler* profiler = new Profiler();
+            return *profiler;
+        }
+
+        static Tree* local_tree() noexcept
+        {
+            thread_local std::shared_ptr<Tree> tree = []() -> std::shared_ptr<Tree> {
+                try {
+                    auto created = std::make_shared<Tree>();
+                    Profiler& profiler = instance();
+                    std::lock_guard lock(profiler.mutex);
+                    profiler.trees.push_back(created);
+                    return created;
+                } catch (...) {
+                    return nullptr;
+                }
+            }();
+            return tree.get();
+        }
+
+        // Make the scope the current node of this thread, creating it on first entry.
+        static ThreadNode* enter(std::string_view name, const std::source_location& location) noexcept
+        {
+            Tree* tree = local_tree();
+            if (!tree) return nullptr;
+
+            ThreadNode* parent = tree->current;
+            for (const auto& child : parent->children) {
+                if (child->location.line() == location.line() && child->location.column() == location.column()
+                    && child->location.file_name() == location.file_name() && child->name == name) {
+                    return tree->current = child.get();
+                }
+            }
+
+            try {
+                auto child = std::make_unique<ThreadNode>();
+                child->name = name;
+                child->location = location;
+                child->parent = parent;
+                std::lock_guard lock(tree->mutex);
+                parent->children.push_back(std::move(child));
+            } catch (...) {
+                return nullptr;
+            }
+            return tree->current = parent->children.back().get();
+        }
+
+        static void leave(ThreadNode* node, int64_t elapsed) noexcept
+        {
+            if (!node) return;
+            node->calls.fetch_add(1, std::memory_order_relaxed);
+            node->inclusive.fetch_add(elapsed, std::memory_order_relaxed);
+            local_tree()->current = node->parent;
+        }
+
+        static void merge(Node& into, const ThreadNode& from)
+        {
+            for (const auto& child : from.children) {
+                auto it = std::find_if(into.children.begin(), into.children.end(), [&](const Node& node) {
+                    return node.name == child->name && node.location.line() == child->location.line()
+                        && std::string_view(node.location.file_name()) == child->location.file_name();
+                });
+                if (it == into.children.end()) {
+                    into.children.push_back({ child->name, child->location, 0, 0, 0, {} });
+                    it = into.children.end() - 1;
+                }
+                it->calls += child->calls.load(std::memory_order_relaxed);
+                it->inclusive += child->inclusive.load(std::memory_order_relaxed);
+                merge(*it, *child);
+            }
+        }
+
+        static void compute_self(Node& node) noexcept
+        {
+            int64_t children = 0;
+            for (Node& child : node.children) {
+                compute_self(child);
+                children += child.inclusive;
+            }
+            node.self = std::max<int64_t>(node.inclusive - children, 0);
+        }
+
+        static void print(std::ostream& stream, const Node& node, std::size_t depth)
+        {
+            DurationBuffer inclusive, self;
+            stream << std::string(depth * 2, ' ') << node.name << " ["
+                   << std::string_view(node.location.file_name()) << ':' << node.location.line() << "] calls: " << node.calls
+                   << ", total: " << automatic_duration_to_chars(inclusive, node.inclusive)
+                   << ", self: " << automatic_duration_to_chars(self, node.self) << '\n';
+            for (const Node& child : node.children) print(stream, child, depth + 1);
+        }
+
+        template <detail::Duration, typename>
+        friend class ProfileTimer;
+
+    public:
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        // Merge every thread's tree. The returned root has no name; its children are the
+        // outermost scopes and its inclusive time is their sum.
+        static Node snapshot()
+        {
+            Profiler& profiler = instance();
+            std::vector<std::shared_ptr<Tree>> trees;
+            {
+                std::lock_guard lock(profiler.mutex);
+                trees = profiler.trees;
+            }
+
+            Node root;
+            for (const auto& tree : trees) {
+                std::lock_guard lock(tree->mutex);
+                merge(root, tree->root);
+            }
+            for (const Node& child : root.children) {
+                root.calls += child.calls;
+                root.inclusive += child.inclusive;
+            }
+            compute_self(root);
+            return root;
+        }
+
+        // Indented call tree with calls, inclusive and self time per path.
+        static void report(std::ostream& stream = std::cout)
+        {
+            Node root = snapshot();
+            for (const Node& child : root.children) print(stream, child, 0);
+            stream.flush();
+        }
+    };
+
+
+    // BlockTimer that also accumulates its time into the Profiler call tree of its thread.
+    // Scopes must be nested, which is what RAII gives for free.
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class ProfileTimer : public BlockTimer<duration, clock>
+    {
+    public:
+        using Base = BlockTimer<duration, clock>;
+        using Settings = typename Base::Settings;
+
+#if TIMED_ENABLED
+    private:
+        Profiler::ThreadNode* node;
+
+        // a scope left out by sampling would re-parent its children, so every scope is timed
+        static Settings every_call(Settings settings) noexcept
+        {
+            settings.sample_every = 1;
+            return settings;
+        }
+
+    public:
+        ProfileTimer(Settings settings) noexcept : Base(every_call(settings)), node(Profiler::enter(settings.name, settings.location))
+        {
+            // restart so the tree bookkeeping stays out of this scope's own time
+            this->start_timer();
+        }
+
+        ~ProfileTimer() noexcept
+        {
+            this->end();
+            Profiler::leave(node, this->get_elapsed());
+        }
+#else
+        constexpr ProfileTimer(Settings settings) noexcept : Base(settings) {}
+#endif
+
+        ProfileTimer(const ProfileTimer&) = delete;
+        ProfileTimer& operator=(const ProfileTimer&) = delete;
+        ProfileTimer(ProfileTimer&&) = delete;
+        ProfileTimer& operator=(ProfileTimer&&) = delete;
+    };
+
+
+    namespace detail
+    {
+        template <typename T>
+        concept MemberCoAwait = requires(T&& awaitable) { std::forward<T>(awaitable).operator co_await(); };
+
+        template <typename T>
+        concept FreeCoAwait = requires(T&& awaitable) { operator co_await(std::forward<T>(awaitable)); };
+
+        // The awaiter `co_await awaitable` would use, or the awaitable itself.
+        template <typename T>
+        decltype(auto) get_awaiter(T&& awaitable)
+        {
+            if constexpr (MemberCoAwait<T>) return std::forward<T>(awaitable).operator co_await();
+            else if constexpr (FreeCoAwait<T>) return operator co_await(std::forward<T>(awaitable));
+            else return std::forward<T>(awaitable);
+        }
+    } // namespace detail
+
+
+    // Follows one logical coroutine task across suspension points, keeping active and suspended
+    // time apart so CPU cost can be told from queueing latency. Keep it in the coroutine frame
+    // and wrap awaits with `co_await timer.track(awaitable)`: time spent suspended in a tracked
+    // await counts as suspended, everything else until `end()` or destruction as active.
+    // The coroutine may resume on another thread; the report is made wherever the timer ends.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class TaskTimer : public detail::BaseTimerFormatter
+    {
+    public:
+        using Settings = detail::BaseTimerSettings;
+
+    private:
+        Settings settings;
+        typename clock::time_point last;
+        typename clock::duration active {};
+        typename clock::duration suspended {};
+        std::uint64_t suspensions = 0;
+        bool is_running = true;
+        bool is_waiting = false;
+
+        template <typename Awaiter>
+        class TrackedAwaiter
+        {
+        private:
+            TaskTimer* timer;
+            Awaiter awaiter;
+
+        public:
+            template <typename Awaitable>
+            TrackedAwaiter(TaskTimer* timer, Awaitable&& awaitable)
+                : timer(timer), awaiter(detail::get_awaiter(std::forward<Awaitable>(awaitable))) {}
+
+            bool await_ready() { return awaiter.await_ready(); }
+
+            // The coroutine may be resumed, even destroyed, on another thread as soon as the inner
+            // await_suspend runs, so the suspension is accounted for before calling it.
+            template <typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle)
+            {
+                timer->suspend();
+                using Result = decltype(awaiter.await_suspend(handle));
+                if constexpr (std::is_void_v<Result>) {
+                    awaiter.await_suspend(handle);
+                } else if constexpr (std::is_same_v<Result, bool>) {
+                    bool suspending = awaiter.await_suspend(handle);
+                    if (!suspending) {
+                        timer->resume();
+                        --timer->suspensions;
+                    }
+                    return suspending;
+                } else {
+                    return awaiter.await_suspend(handle);
+                }
+            }
+
+            decltype(auto) await_resume()
+            {
+                timer->resume();
+                return awaiter.await_resume();
+            }
+        };
+
+    public:
+        TaskTimer(const TaskTimer&) = delete;
+        TaskTimer& operator=(const TaskTimer&) = delete;
+        TaskTimer(TaskTimer&&) = delete;
+        TaskTimer& operator=(TaskTimer&&) = delete;
+
+        TaskTimer(Settings settings) noexcept : settings(settings), last(clock::now()) {}
+
+        ~TaskTimer() noexcept
+        {
+            end();
+            if (!settings.show_output) return;
+
+            // sinks get the active time as the interval [0, active]
+            if (settings.sink) {
+                settings.sink->write({ settings.name, settings.location, 0, get_active_time() });
+                return;
+            }
+
+            DurationBuffer buffer;
+            std::string result = "active ";
+            result += duration_to_chars<duration>(buffer, get_active_time());
+            result += ", suspended ";
+            result += duration_to_chars<duration>(buffer, get_suspended_time());
+            result += " (" + std::to_string(suspensions) + " suspensions)";
+            write_output(result, settings);
+        }
+
+        // Wrap an awaitable so the time suspended in it counts as suspended time.
+        template <typename Awaitable>
+        auto track(Awaitable&& awaitable)
+        {
+            using Awaiter = decltype(detail::get_awaiter(std::forward<Awaitable>(awaitable)));
+            return TrackedAwaiter<Awaiter>(this, std::forward<Awaitable>(awaitable));
+        }
+
+        // Manual accounting, for suspension points that cannot be wrapped.
+        void suspend() noexcept
+        {
+            if (!is_running || is_waiting) return;
+            auto now = clock::now();
+            active += now - last;
+            last = now;
+            is_waiting = true;
+            ++suspensions;
+        }
+
+        void resume() noexcept
+        {
+            if (!is_running || !is_waiting) return;
+            auto now = clock::now();
+            suspended += now - last;
+            last = now;
+            is_waiting = false;
+        }
+
+        // Stop the timer; the first call also records the active time like other timers do.
+        void end() noexcept
+        {
+            if (!is_running) return;
+            resume();
+            active += clock::now() - last;
+            is_running = false;
+
+            int64_t elapsed = get_active_time();
+            if (settings.record) Registry::record(settings.name, settings.location, elapsed);
+            if (settings.histogram) settings.histogram->record(elapsed);
+            if (settings.baseline) settings.baseline->record(settings.name, elapsed);
+        }
+
+        // All times are in nanoseconds.
+        [[nodiscard]] int64_t get_active_time() const noexcept { return detail::to_nanoseconds<clock>(active); }
+        [[nodiscard]] int64_t get_suspended_time() const noexcept { return detail::to_nanoseconds<clock>(suspended); }
+        [[nodiscard]] int64_t get_total_time() const noexcept { return detail::to_nanoseconds<clock>(active + suspended); }
+        [[nodiscard]] std::uint64_t get_suspensions() const noexcept { return suspensions; }
+        [[nodiscard]] bool is_suspended() const noexcept { return is_waiting; }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class TaskTimer
+    {
+    public:
+        using Settings = detail::BaseTimerSettings;
+
+        TaskTimer(const TaskTimer&) = delete;
+        TaskTimer& operator=(const TaskTimer&) = delete;
+        TaskTimer(TaskTimer&&) = delete;
+        TaskTimer& operator=(TaskTimer&&) = delete;
+
+        constexpr TaskTimer(Settings) noexcept {}
+
+        // awaits the awaitable unchanged
+        template <typename Awaitable>
+        constexpr Awaitable&& track(Awaitable&& awaitable) noexcept { return std::forward<Awaitable>(awaitable); }
+
+        constexpr void suspend() noexcept {}
+        constexpr void resume() noexcept {}
+        constexpr void end() noexcept {}
+
+        [[nodiscard]] constexpr int64_t get_active_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_suspended_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr int64_t get_total_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr std::uint64_t get_suspensions() const noexcept { return 0; }
+        [[nodiscard]] constexpr bool is_suspended() const noexcept { return false; }
+    };
+#endif
+
+
+    namespace detail
+    {
+        // Resolution and call cost of `clock::now()`, measured once per clock type.
+        template <typename clock>
+        struct ClockCalibration
+        {
+            double resolution = 0; // smallest observable step, in ns
+            double overhead = 0;   // cost of one `clock::now()` call, in ns
+
+            static const ClockCalibration& get() noexcept
+            {
+                static const ClockCalibration calibration = measure();
+                return calibration;
+            }
+
+        private:
+            static ClockCalibration measure() noexcept
+            {
+                ClockCalibration calibration { std::numeric_limits<double>::max(), 0 };
+
+                for (int i = 0; i < 1000; ++i) {
+                    auto t0 = clock::now();
+                    auto t1 = clock::now();
+                    while (t1 == t0) t1 = clock::now();
+                    calibration.resolution = std::min(calibration.resolution, to_nanoseconds_f<clock>(t1 - t0));
+                }
+
+                constexpr int calls = 10'000;
+                auto start = clock::now();
+                for (int i = 0; i < calls; ++i) {
+                    auto now = clock::now();
+                    do_not_optimize(now);
+                }
+                calibration.overhead = to_nanoseconds_f<clock>(clock::now() - start) / calls;
+                return calibration;
+            }
+        };
+    } // namespace detail
+
+
+    // Micro-benchmark of a callable, in the spirit of google-benchmark: the callable is warmed up,
+    // then timed in batches whose size is calibrated until a batch lasts `resolution_multiple`
+    // clock ticks, and long enough that reading the clock costs at most `max_clock_overhead` of
+    // it. The empty-loop and `clock::now()` costs are measured and subtracted, and every
+    // result and argument goes through `do_not_optimize` so the work cannot be elided.
+    // The batch loop body makes `unroll` calls, expanded at compile time; 8 or 16 make the loop
+    // cost negligible for few-ns functions. The per-call time is reported with an error bound.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock, std::size_t unroll = 1>
+    class Benchmark : public detail::BaseTimerFormatter
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t samples = 30;                             // timed batches
+            std::chrono::nanoseconds warmup = std::chrono::milliseconds(100);
+            std::size_t resolution_multiple = 1000;               // minimal batch length, in clock ticks
+            double max_clock_overhead = 0.001;                    // highest share of a batch spent reading the clock
+        };
+
+    private:
+        static_assert(unroll > 0, "the unroll factor must be at least 1");
+        // bounds calibration when the callable is too cheap to measure at all
+        static constexpr std::size_t max_batch_size = std::size_t(1) << 30;
+
+        Settings settings;
+
+        std::size_t batch_size = unroll; // always a multiple of `unroll`
+        double loop_overhead = 0;  // ns per empty iteration
+        std::vector<double> per_call; // ns per call of each sample, sorted
+
+        template <typename Callable, typename... Args>
+        static void invoke(Callable& function, Args&... args) noexcept(noexcept(std::invoke(function, args...)))
+        {
+            (do_not_optimize(args), ...);
+            if constexpr (std::is_void_v<std::invoke_result_t<Callable&, Args&...>>) {
+                std::invoke(function, args...);
+            } else {
+                do_not_optimize(std::invoke(function, args...));
+            }
+        }
+
+        template <typename Callable, typename... Args>
+        static double time_batch(std::size_t size, Callable& function, Args&... args)
+        {
+            auto start = clock::now();
+            for (std::size_t i = 0; i < size; i += unroll) {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    ((static_cast<void>(I), invoke(function, args...)), ...);
+                }(std::make_index_sequence<unroll> {});
+            }
+            auto end = clock::now();
+            return detail::to_nanoseconds_f<clock>(end - start);
+        }
+
+        template <typename... Args>
+        static double time_empty_batch(std::size_t size, Args&... args) noexcept
+        {
+            auto start = clock::now();
+            for (std::size_t i = 0; i < size; i += unroll) {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    ((static_cast<void>(I), (do_not_optimize(args), ...)), ...);
+                }(std::make_index_sequence<unroll> {});
+            }
+            auto end = clock::now();
+            return detail::to_nanoseconds_f<clock>(end - start);
+        }
+
+    public:
+        Benchmark(const Benchmark&) = delete;
+        Benchmark& operator=(const Benchmark&) = delete;
+        Benchmark(Benchmark&&) = delete;
+        Benchmark& operator=(Benchmark&&) = delete;
+
+        template <typename Callable, typename... Args>
+        Benchmark(Settings settings, Callable&& function, Args&&... args) : settings(settings)
+        {
+            const auto& calibration = detail::ClockCalibration<clock>::get();
+
+            // warmup, at least one call
+            const auto warmup_start = clock::now();
+            const auto warmup = static_cast<double>(this->settings.warmup.count());
+            do { invoke(function, args...); } while (detail::to_nanoseconds_f<clock>(clock::now() - warmup_start) < warmup);
+
+            // grow the batch until it clearly exceeds the clock resolution, and until the cost of
+            // reading the clock is at most `max_clock_overhead` of it
+            const double target = std::max(calibration.resolution * static_cast<double>(this->settings.resolution_multiple),
+                                           this->settings.max_clock_overhead > 0 ? calibration.overhead / this->settings.max_clock_overhead : 0.0);
+            for (;;) {
+                double elapsed = time_batch(batch_size, function, args...);
+                if (elapsed >= target || batch_size >= max_batch_size) break;
+                double scale = elapsed > 0 ? 1.4 * target / elapsed : 10.0;
+                batch_size = std::min(max_batch_size,
+                    static_cast<std::size_t>(static_cast<double>(batch_size) * std::clamp(scale, 2.0, 10.0)));
+                batch_size = (batch_size + unroll - 1) / unroll * unroll;
+            }
+
+            // cheapest of a few runs, as the loop cost only ever gets inflated by noise
+            loop_overhead = std::numeric_limits<double>::max();
+            for (int i = 0; i < 5; ++i) {
+                double empty = time_empty_batch(batch_size, args...) - calibration.overhead;
+                loop_overhead = std::min(loop_overhead, std::max(empty, 0.0) / static_cast<double>(batch_size));
+            }
+
+            per_call.reserve(this->settings.samples);
+            for (std::size_t i = 0; i < std::max<std::size_t>(this->settings.samples, 1); ++i) {
+                double elapsed = time_batch(batch_size, function, args...) - calibration.overhead;
+                per_call.push_back(std::max(elapsed / static_cast<double>(batch_size) - loop_overhead, 0.0));
+            }
+            std::sort(per_call.begin(), per_call.end());
+        }
+
+        ~Benchmark()
+        {
+            if (!settings.show_output) return;
+
+            DurationBuffer buffer;
+            std::string result(duration_to_chars<duration>(buffer, get_average_time()));
+            result += " +/- ";
+            result += duration_to_chars<duration>(buffer, get_error());
+            write_output(result, settings);
+        }
+
+        // Half-width of a 95% interval around the average per-call time, in nanoseconds: the
+        // confidence interval of the mean over the samples, plus the clock resolution and the
+        // subtracted `clock::now()` cost spread over a batch, which bound the error of each pair
+        // of timestamps.
+        [[nodiscard]] double get_error() const noexcept
+        {
+            const auto n = static_cast<double>(per_call.size());
+            double variance = 0;
+            if (per_call.size() > 1) {
+                const double mean = get_average_time();
+                for (double sample : per_call) variance += (sample - mean) * (sample - mean);
+                variance /= n - 1;
+            }
+            return 1.96 * std::sqrt(variance / n) + get_clock_error();
+        }
+
+        // Timestamp error per call: clock resolution plus clock overhead, over the batch size.
+        [[nodiscard]] double get_clock_error() const noexcept
+        {
+            return (get_clock_resolution() + get_clock_overhead()) / static_cast<double>(batch_size);
+        }
+
+        // Per-call times in nanoseconds, with the measurement overhead subtracted.
+        [[nodiscard]] double get_average_time() const noexcept
+        {
+            return std::accumulate(per_call.begin(), per_call.end(), 0.0) / static_cast<double>(per_call.size());
+        }
+        [[nodiscard]] double get_min_time() const noexcept { return per_call.front(); }
+        [[nodiscard]] double get_max_time() const noexcept { return per_call.back(); }
+        [[nodiscard]] double get_median_time() const noexcept
+        {
+            std::size_t n = per_call.size();
+            return (n & 1) ? per_call[n / 2] : (per_call[n / 2 - 1] + per_call[n / 2]) / 2;
+        }
+
+        [[nodiscard]] std::size_t get_batch_size() const noexcept { return batch_size; }
+        [[nodiscard]] std::size_t get_iterations() const noexcept { return batch_size * per_call.size(); }
+        // Per-call time of every sample, in nanoseconds, sorted.
+        [[nodiscard]] const std::vector<double>& get_samples() const noexcept { return per_call; }
+        [[nodiscard]] double get_loop_overhead() const noexcept { return loop_overhead; }
+        [[nodiscard]] double get_clock_overhead() const noexcept { return detail::ClockCalibration<clock>::get().overhead; }
+        [[nodiscard]] double get_clock_resolution() const noexcept { return detail::ClockCalibration<clock>::get().resolution; }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock, std::size_t unroll = 1>
+    class Benchmark
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t samples = 30;
+            std::chrono::nanoseconds warmup = std::chrono::milliseconds(100);
+            std::size_t resolution_multiple = 1000;
+            double max_clock_overhead = 0.001;
+        };
+
+        Benchmark(const Benchmark&) = delete;
+        Benchmark& operator=(const Benchmark&) = delete;
+        Benchmark(Benchmark&&) = delete;
+        Benchmark& operator=(Benchmark&&) = delete;
+
+        // calls the function once, so side effects are preserved
+        template <typename Callable, typename... Args>
+        Benchmark(Settings, Callable&& function, Args&&... args)
+        {
+            std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] constexpr double get_error() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_clock_error() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_average_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_min_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_max_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_median_time() const noexcept { return 0; }
+        [[nodiscard]] constexpr std::size_t get_batch_size() const noexcept { return 0; }
+        [[nodiscard]] constexpr std::size_t get_iterations() const noexcept { return 0; }
+        [[nodiscard]] const std::vector<double>& get_samples() const noexcept
+        {
+            static const std::vector<double> none;
+            return none;
+        }
+        [[nodiscard]] constexpr double get_loop_overhead() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_clock_overhead() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_clock_resolution() const noexcept { return 0; }
+    };
+#endif
+
+
+    namespace detail
+    {
+        // Pin the calling thread to one CPU; a no-op where affinity is not supported.
+        inline bool pin_current_thread(unsigned cpu) noexcept
+        {
+#if TIMED_HAS_AFFINITY
+            if (cpu >= CPU_SETSIZE) return false;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            (void)cpu;
+            return false;
+#endif
+        }
+    } // namespace detail
+
+
+    // Stabilizes the calling thread for benchmark runs and describes the machine: pins the
+    // thread to `cpu`, raises its scheduling priority, and warns on `warning_stream` when the
+    // CPU frequency governor is not "performance" or turbo boost is enabled, since both make
+    // numbers drift between runs. The previous affinity and priority are restored on destruction.
+    // `get_metadata()` records the CPU model, frequencies and kernel for the results, e.g.
+    // through Baseline::set_metadata. Only Linux is stabilized; elsewhere this only describes.
+    class Environment
+    {
+    public:
+        struct Options
+        {
+            int cpu = -1;                       // CPU to pin to, -1 keeps the current affinity
+            bool raise_priority = true;         // nice -20, needs CAP_SYS_NICE or root
+            bool warn = true;
+            std::ostream& warning_stream = std::cerr;
+        };
+
+        struct Metadata
+        {
+            std::string cpu_model = "unknown";
+            unsigned cpus = 0;
+            int cpu = -1;                       // CPU pinned to, or -1
+            double frequency_mhz = 0;           // current frequency of that CPU, 0 if unknown
+            double max_frequency_mhz = 0;
+            std::string governor;               // empty if cpufreq is not available
+            std::optional<bool> turbo;          // unknown without intel_pstate or cpufreq boost
+            std::string kernel;                 // system, release and version
+            std::string hostname;
+            bool priority_raised = false;
+            std::vector<std::string> warnings;
+
+            // Key/value pairs for result files.
+            [[nodiscard]] std::vector<std::pair<std::string, std::string>> entries() const
+            {
+                auto number = [](double value) {
+                    char buffer[32];
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 0);
+                    return std::string(buffer, end);
+                };
+                return {
+                    { "cpu_model", cpu_model },
+                    { "cpus", std::to_string(cpus) },
+                    { "pinned_cpu", std::to_string(cpu) },
+                    { "frequency_mhz", number(frequency_mhz) },
+                    { "max_frequency_mhz", number(max_frequency_mhz) },
+                    { "governor", governor.empty() ? "unknown" : governor },
+                    { "turbo", turbo ? (*turbo ? "on" : "off") : "unknown" },
+                    { "kernel", kernel },
+                    { "hostname", hostname },
+                };
+            }
+
+            void write_json(std::ostream& stream) const
+            {
+                stream << '{';
+                bool first = true;
+                for (const auto& [key, value] : entries()) {
+                    stream << (first ? "\"" : ",\"") << key << "\":\"";
+                    detail::write_escaped(stream, value);
+                    stream << '"';
+                    first = false;
+                }
+                stream << ",\"warnings\":[";
+                for (std::size_t i = 0; i < warnings.size(); ++i) {
+                    stream << (i ? ",\"" : "\"");
+                    detail::write_escaped(stream, warnings[i]);
+                    stream << '"';
+                }
+                stream << "]}";
+            }
+        };
+
+    private:
+        Options options;
+        Metadata metadata;
+#if TIMED_HAS_AFFINITY
+        cpu_set_t previous_affinity {};
+        bool pinned = false;
+        pid_t thread_id = 0;
+        int previous_nice = 0;
+#endif
+
+        static std::string read_line(const std::string& path)
+        {
+            std::ifstream file(path);
+            std::string line;
+            std::getline(file, line);
+            return line;
+        }
+
+        void warn(std::string message)
+        {
+            if (options.warn) options.warning_stream << "Timed: warning: " << message << std::endl;
+            metadata.warnings.push_back(std::move(message));
+        }
+
+    public:
+        Environment(const Environment&) = delete;
+        Environment& operator=(const Environment&) = delete;
+        Environment(Environment&&) = delete;
+        Environment& operator=(Environment&&) = delete;
+
+        explicit Environment(Options options) : options(options)
+        {
+#if TIMED_HAS_AFFINITY
+            if (this->options.cpu >= 0) {
+                pinned = pthread_getaffinity_np(pthread_self(), sizeof(previous_affinity), &previous_affinity) == 0 &&
+                         detail::pin_current_thread(static_cast<unsigned>(this->options.cpu));
+                if (!pinned) warn("could not pin the thread to CPU " + std::to_string(this->options.cpu));
+            }
+            if (this->options.raise_priority) {
+                thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+                errno = 0;
+                previous_nice = getpriority(PRIO_PROCESS, static_cast<id_t>(thread_id));
+                metadata.priority_raised = errno == 0 && setpriority(PRIO_PROCESS, static_cast<id_t>(thread_id), -20) == 0;
+                if (!metadata.priority_raised) warn("could not raise the thread priority (needs CAP_SYS_NICE)");
+            }
+#else
+            if (this->options.cpu >= 0 || this->options.raise_priority) warn("pinning and priority are only supported on Linux");
+#endif
+            Metadata detected = detect(pinned_cpu());
+            detected.priority_raised = metadata.priority_raised;
+            detected.warnings = std::move(metadata.warnings);
+            metadata = std::move(detected);
+
+            if (!metadata.governor.empty() && metadata.governor != "performance")
+                warn("CPU frequency governor is \"" + metadata.governor + "\", not \"performance\"");
+            if (metadata.turbo.value_or(false)) warn("turbo boost is enabled, frequencies vary with load and temperature");
+        }
+
+        Environment() : Environment(Options {}) {}
+
+        ~Environment()
+        {
+#if TIMED_HAS_AFFINITY
+            if (pinned) pthread_setaffinity_np(pthread_self(), sizeof(previous_affinity), &previous_affinity);
+            if (metadata.priority_raised) setpriority(PRIO_PROCESS, static_cast<id_t>(thread_id), previous_nice);
+#endif
+        }
+
+        // Describe the machine without changing anything; frequencies are those of `cpu`, or
+        // of CPU 0 when it is -1.
+        static Metadata detect(int cpu = -1)
+        {
+            Metadata metadata;
+            metadata.cpus = std::thread::hardware_concurrency();
+            metadata.cpu = cpu;
+#if defined(__linux__)
+            std::ifstream cpuinfo("/proc/cpuinfo");
+            for (std::string line; std::getline(cpuinfo, line);) {
+                auto colon = line.find(':');
+                if (colon == std::string::npos) continue;
+                std::string_view key = std::string_view(line).substr(0, colon);
+                while (!key.empty() && (key.back() == ' ' || key.back() == '\t')) key.remove_suffix(1);
+                std::string value = line.substr(std::min(colon + 2, line.size()));
+                // x86 reports "model name", AArch64 only "CPU part" unless the kernel knows the name
+                if (key == "model name" || (key == "Hardware" && metadata.cpu_model == "unknown")) {
+                    metadata.cpu_model = value;
+                    if (key == "model name") break;
+                }
+            }
+
+            const std::string cpufreq = "/sys/devices/system/cpu/cpu" + std::to_string(std::max(cpu, 0)) + "/cpufreq/";
+            auto khz = [](const std::string& text) { return text.empty() ? 0.0 : std::strtod(text.c_str(), nullptr) / 1000.0; };
+            metadata.frequency_mhz = khz(read_line(cpufreq + "scaling_cur_freq"));
+            metadata.max_frequency_mhz = khz(read_line(cpufreq + "cpuinfo_max_freq"));
+            metadata.governor = read_line(cpufreq + "scaling_governor");
+            if (metadata.frequency_mhz == 0) {
+                std::ifstream again("/proc/cpuinfo");
+                for (std::string line; std::getline(again, line);) {
+                    if (!line.starts_with("cpu MHz")) continue;
+                    auto colon = line.find(':');
+                    if (colon != std::string::npos) metadata.frequency_mhz = std::strtod(line.c_str() + colon + 1, nullptr);
+                    break;
+                }
+            }
+
+            if (std::string no_turbo = read_line("/sys/devices/system/cpu/intel_pstate/no_turbo"); !no_turbo.empty())
+                metadata.turbo = no_turbo == "0";
+            else if (std::string boost = read_line("/sys/devices/system/cpu/cpufreq/boost"); !boost.empty())
+                metadata.turbo = boost == "1";
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+            utsname system {};
+            if (uname(&system) == 0) {
+                metadata.kernel = std::string(system.sysname) + " " + system.release + " " + system.version;
+                metadata.hostname = system.nodename;
+            }
+#endif
+            return metadata;
+        }
+
+        [[nodiscard]] const Metadata& get_metadata() const noexcept { return metadata; }
+        [[nodiscard]] int pinned_cpu() const noexcept
+        {
+#if TIMED_HAS_AFFINITY
+            return pinned ? options.cpu : -1;
+#else
+            return -1;
+#endif
+        }
+    };
+
+
+    // Runs a callable on several threads at once, like `->Threads()` in google-benchmark.
+    // Threads are released together from a shared start barrier, then each times its own
+    // `iterations` calls. With `scaling`, the run is repeated for 1, 2, 4, ... up to `threads`
+    // threads, and the scaling efficiency of each run is relative to the smallest one.
+    // The callable and arguments are shared by every thread and must be safe to call concurrently.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class ThreadedFunctionTimer : public detail::BaseTimerFormatter
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t threads = 0;        // 0 uses std::thread::hardware_concurrency()
+            std::size_t iterations = 1000;  // calls per thread
+            bool pin_threads = false;       // pin thread i to CPU i
+            bool scaling = false;
+        };
+
+        struct Run
+        {
+            std::size_t threads = 0;
+            double wall_time = 0;                       // ns, from release to the last thread done
+            double throughput = 0;                      // calls per second, all threads
+            double efficiency = 1;                      // throughput per thread relative to the smallest run
+            std::vector<double> thread_throughput;      // calls per second, per thread
+            Histogram::Snapshot latency;                // per-call times of all threads, ns
+        };
+
+    private:
+        Settings settings;
+        std::vector<Run> runs;
+
+        template <typename Callable, typename... Args>
+        Run run(std::size_t count, Callable& function, Args&... args)
+        {
+            Run result;
+            result.threads = count;
+            result.thread_throughput.resize(count);
+
+            std::vector<Histogram::Snapshot> latencies(count);
+            std::vector<typename clock::time_point> ends(count);
+            std::atomic<std::size_t> ready { 0 };
+            std::atomic<bool> go { false };
+            const std::size_t iterations = std::max<std::size_t>(settings.iterations, 1);
+
+            auto worker = [&](std::size_t index) {
+                if (settings.pin_threads) detail::pin_current_thread(static_cast<unsigned>(index));
+                ready.fetch_add(1, std::memory_order_release);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+                // each thread records into its own histogram, merged into `histogram` and `baseline`
+                // after the join, and into its own Registry shard; the clock is read again so
+                // recording stays out of the next call
+                Histogram::Snapshot& latency = latencies[index];
+                const auto start = clock::now();
+                auto last = start;
+                for (std::size_t i = 0; i < iterations; ++i) {
+                    if constexpr (std::is_void_v<std::invoke_result_t<Callable&, Args&...>>) {
+                        std::invoke(function, args...);
+                    } else {
+                        do_not_optimize(std::invoke(function, args...));
+                    }
+                    auto now = clock::now();
+                    int64_t elapsed = detail::to_nanoseconds<clock>(now - last);
+                    latency.record(elapsed);
+                    if (settings.record) Registry::record(settings.name, settings.location, elapsed);
+                    last = clock::now();
+                }
+                ends[index] = last;
+                double seconds = detail::to_nanoseconds_f<clock>(last - start) / 1e9;
+                result.thread_throughput[index] = seconds > 0 ? static_cast<double>(iterations) / seconds : 0.0;
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) threads.emplace_back(worker, i);
+            while (ready.load(std::memory_order_acquire) != count) std::this_thread::yield();
+            const auto release = clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& thread : threads) thread.join();
+
+            for (std::size_t i = 0; i < count; ++i) {
+                result.latency.merge(latencies[i]);
+                result.wall_time = std::max(result.wall_time, detail::to_nanoseconds_f<clock>(ends[i] - release));
+            }
+            if (settings.histogram) settings.histogram->merge(result.latency);
+            if (settings.baseline) settings.baseline->merge(settings.name, result.latency);
+            if (result.wall_time > 0) result.throughput = static_cast<double>(iterations * count) / (result.wall_time / 1e9);
+            return result;
+        }
+
+    public:
+        ThreadedFunctionTimer(const ThreadedFunctionTimer&) = delete;
+        ThreadedFunctionTimer& operator=(const ThreadedFunctionTimer&) = delete;
+        ThreadedFunctionTimer(ThreadedFunctionTimer&&) = delete;
+        ThreadedFunctionTimer& operator=(ThreadedFunctionTimer&&) = delete;
+
+        template <typename Callable, typename... Args>
+        ThreadedFunctionTimer(Settings settings, Callable&& function, Args&&... args) : settings(settings)
+        {
+            std::size_t threads = this->settings.threads ? this->settings.threads : std::thread::hardware_concurrency();
+            threads = std::max<std::size_t>(threads, 1);
+
+            if (this->settings.scaling) {
+                for (std::size_t count = 1; count < threads; count *= 2) runs.push_back(run(count, function, args...));
+            }
+            runs.push_back(run(threads, function, args...));
+
+            const Run& base = runs.front();
+            for (Run& entry : runs) {
+                double ideal = base.throughput * static_cast<double>(entry.threads) / static_cast<double>(base.threads);
+                entry.efficiency = ideal > 0 ? entry.throughput / ideal : 0.0;
+            }
+        }
+
+        ~ThreadedFunctionTimer()
+        {
+            if (!settings.show_output) return;
+
+            // like AverageFunctionTimer, sinks get the interval [0, average latency] of each run
+            if (settings.sink) {
+                for (const Run& entry : runs) settings.sink->write({ settings.name, settings.location, 0, entry.latency.get_average() });
+                return;
+            }
+
+            for (const Run& entry : runs) {
+                DurationBuffer buffer;
+                std::string result = std::to_string(entry.threads) + " threads: " +
+                    std::to_string(static_cast<std::uint64_t>(entry.throughput)) + " ops/s, p50 ";
+                result += duration_to_chars<duration>(buffer, entry.latency.get_percentile(0.5));
+                result += ", p99 ";
+                result += duration_to_chars<duration>(buffer, entry.latency.get_percentile(0.99));
+                result += ", efficiency " + std::to_string(static_cast<int>(entry.efficiency * 100 + 0.5)) + "%";
+                write_output(result, settings);
+            }
+        }
+
+        // One entry per thread count, in increasing order; the last one uses `threads` threads.
+        [[nodiscard]] const std::vector<Run>& get_runs() const noexcept { return runs; }
+        [[nodiscard]] std::size_t get_threads() const noexcept { return runs.back().threads; }
+        [[nodiscard]] double get_throughput() const noexcept { return runs.back().throughput; }
+        [[nodiscard]] double get_efficiency() const noexcept { return runs.back().efficiency; }
+        [[nodiscard]] const Histogram::Snapshot& get_latency() const noexcept { return runs.back().latency; }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class ThreadedFunctionTimer
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t threads = 0;
+            std::size_t iterations = 1000;
+            bool pin_threads = false;
+            bool scaling = false;
+        };
+
+        struct Run
+        {
+            std::size_t threads = 0;
+            double wall_time = 0;
+            double throughput = 0;
+            double efficiency = 1;
+            std::vector<double> thread_throughput;
+            Histogram::Snapshot latency;
+        };
+
+    private:
+        std::vector<Run> runs;
+        Histogram::Snapshot latency;
+
+    public:
+        ThreadedFunctionTimer(const ThreadedFunctionTimer&) = delete;
+        ThreadedFunctionTimer& operator=(const ThreadedFunctionTimer&) = delete;
+        ThreadedFunctionTimer(ThreadedFunctionTimer&&) = delete;
+        ThreadedFunctionTimer& operator=(ThreadedFunctionTimer&&) = delete;
+
+        // calls the function once, on the calling thread, so side effects are preserved
+        template <typename Callable, typename... Args>
+        ThreadedFunctionTimer(Settings, Callable&& function, Args&&... args)
+        {
+            std::invoke(std::forward<Callable>(function), std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] const std::vector<Run>& get_runs() const noexcept { return runs; }
+        [[nodiscard]] constexpr std::size_t get_threads() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_throughput() const noexcept { return 0; }
+        [[nodiscard]] constexpr double get_efficiency() const noexcept { return 0; }
+        [[nodiscard]] const Histogram::Snapshot& get_latency() const noexcept { return latency; }
+    };
+#endif
+
+
+    // Candidate models for Sweep, from the cheapest; they compare in that order, so
+    // `sweep.get_complexity() <= Timed::Complexity::n` reads as "at most linear".
+    enum class Complexity { constant, log_n, n, n_log_n, n_squared };
+
+    constexpr std::string_view to_string(Complexity complexity) noexcept
+    {
+        switch (complexity) {
+            case Complexity::constant: return "O(1)";
+            case Complexity::log_n: return "O(log n)";
+            case Complexity::n: return "O(n)";
+            case Complexity::n_log_n: return "O(n log n)";
+            case Complexity::n_squared: return "O(n^2)";
+        }
+        return "O(?)";
+    }
+
+    // Least-squares fit of `time = coefficient * f(n)`; `rms` is the residual RMS relative
+    // to the mean time, so 0.05 means the model is off by 5% on average.
+    struct ComplexityFit
+    {
+        Complexity complexity = Complexity::constant;
+        double coefficient = 0; // ns per unit of f(n)
+        double rms = 0;
+    };
+
+    namespace detail
+    {
+        inline double complexity_term(Complexity complexity, double n) noexcept
+        {
+            switch (complexity) {
+                case Complexity::constant: return 1.0;
+                case Complexity::log_n: return std::log2(std::max(n, 2.0));
+                case Complexity::n: return n;
+                case Complexity::n_log_n: return n * std::log2(std::max(n, 2.0));
+                case Complexity::n_squared: return n * n;
+            }
+            return 1.0;
+        }
+
+        inline ComplexityFit fit_complexity(Complexity complexity, const std::vector<std::pair<int64_t, int64_t>>& points) noexcept
+        {
+            double fy = 0, ff = 0, mean = 0;
+            for (auto [n, time] : points) {
+                double f = complexity_term(complexity, static_cast<double>(n));
+                fy += f * static_cast<double>(time);
+                ff += f * f;
+                mean += static_cast<double>(time);
+            }
+            mean /= static_cast<double>(std::max<std::size_t>(points.size(), 1));
+
+            ComplexityFit fit { complexity, ff > 0 ? fy / ff : 0.0, 0.0 };
+            double squares = 0;
+            for (auto [n, time] : points) {
+                double residual = static_cast<double>(time) - fit.coefficient * complexity_term(complexity, static_cast<double>(n));
+                squares += residual * residual;
+            }
+            double rms = std::sqrt(squares / static_cast<double>(std::max<std::size_t>(points.size(), 1)));
+            fit.rms = mean > 0 ? rms / mean : 0.0;
+            return fit;
+        }
+
+        // The model with the lowest relative RMS error.
+        inline ComplexityFit best_complexity_fit(const std::vector<std::pair<int64_t, int64_t>>& points) noexcept
+        {
+            ComplexityFit best = fit_complexity(Complexity::constant, points);
+            for (auto complexity : { Complexity::log_n, Complexity::n, Complexity::n_log_n, Complexity::n_squared }) {
+                ComplexityFit fit = fit_complexity(complexity, points);
+                if (fit.rms < best.rms) best = fit;
+            }
+            return best;
+        }
+    } // namespace detail
+
+
+    // Arguments from `low` to `high`, multiplied by `multiplier` each step; `high` is always
+    // included, e.g. geometric_range(8, 100, 4) is { 8, 32, 100 }.
+    inline std::vector<int64_t> geometric_range(int64_t low, int64_t high, int64_t multiplier = 2)
+    {
+        std::vector<int64_t> range;
+        multiplier = std::max<int64_t>(multiplier, 2);
+        for (int64_t n = std::max<int64_t>(low, 1); n < high; n *= multiplier) {
+            range.push_back(n);
+            if (n > std::numeric_limits<int64_t>::max() / multiplier) break;
+        }
+        range.push_back(high);
+        return range;
+    }
+
+
+    // Times `function(n, args...)` for every `n` in `Settings::arguments`, taking the median
+    // of `iterations` calls per point, then fits O(1), O(log n), O(n), O(n log n) and O(n^2)
+    // to the results and keeps the best one. The `record`, `histogram` and `baseline` settings
+    // are ignored, as they would merge the points; use `get_points()`.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class Sweep : public detail::BaseTimerFormatter
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::vector<int64_t> arguments;
+            std::size_t iterations = 10; // per argument
+        };
+
+    private:
+        Settings settings;
+        std::vector<std::pair<int64_t, int64_t>> points; // argument, median time in ns
+        ComplexityFit fit;
+
+    public:
+        Sweep(const Sweep&) = delete;
+        Sweep& operator=(const Sweep&) = delete;
+        Sweep(Sweep&&) = delete;
+        Sweep& operator=(Sweep&&) = delete;
+
+        template <typename Callable, typename... Args>
+        Sweep(Settings settings, Callable&& function, Args&&... args) : settings(std::move(settings))
+        {
+            using Timer = AverageFunctionTimer<duration, clock>;
+            // one destination cannot tell the points apart, so the timers do not feed any
+            typename Timer::Settings point_settings { this->settings, this->settings.iterations };
+            point_settings.show_output = false;
+            point_settings.record = false;
+            point_settings.histogram = nullptr;
+            point_settings.baseline = nullptr;
+
+            points.reserve(this->settings.arguments.size());
+            for (int64_t n : this->settings.arguments) {
+                Timer timer(point_settings, function, n, args...);
+                points.emplace_back(n, timer.get_median_time());
+            }
+            if (!points.empty()) fit = detail::best_complexity_fit(points);
+        }
+
+        ~Sweep()
+        {
+            if (!settings.show_output) return;
+
+            DurationBuffer buffer;
+            for (auto [n, time] : points) {
+                std::string result = "n = " + std::to_string(n) + ": ";
+                result += duration_to_chars<duration>(buffer, time);
+                write_output(result, settings);
+            }
+            if (points.empty()) return;
+
+            std::string result(to_string(fit.complexity));
+            result += ", RMS " + std::to_string(static_cast<int>(fit.rms * 100 + 0.5)) + "%";
+            write_output(result, settings);
+        }
+
+        // (argument, median time in ns) for each point, in `Settings::arguments` order.
+        [[nodiscard]] const std::vector<std::pair<int64_t, int64_t>>& get_points() const noexcept { return points; }
+        [[nodiscard]] const ComplexityFit& get_fit() const noexcept { return fit; }
+        [[nodiscard]] Complexity get_complexity() const noexcept { return fit.complexity; }
+        [[nodiscard]] double get_rms() const noexcept { return fit.rms; }
+        // Fit of a given model, e.g. to check how far the data is from O(n).
+        [[nodiscard]] ComplexityFit get_fit(Complexity complexity) const noexcept { return detail::fit_complexity(complexity, points); }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class Sweep
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::vector<int64_t> arguments;
+            std::size_t iterations = 10;
+        };
+
+    private:
+        std::vector<std::pair<int64_t, int64_t>> points;
+        ComplexityFit fit;
+
+    public:
+        Sweep(const Sweep&) = delete;
+        Sweep& operator=(const Sweep&) = delete;
+        Sweep(Sweep&&) = delete;
+        Sweep& operator=(Sweep&&) = delete;
+
+        // calls the function once per argument, so side effects are preserved
+        template <typename Callable, typename... Args>
+        Sweep(Settings settings, Callable&& function, Args&&... args)
+        {
+            for (int64_t n : settings.arguments) std::invoke(function, n, args...);
+        }
+
+        [[nodiscard]] const std::vector<std::pair<int64_t, int64_t>>& get_points() const noexcept { return points; }
+        [[nodiscard]] const ComplexityFit& get_fit() const noexcept { return fit; }
+        [[nodiscard]] constexpr Complexity get_complexity() const noexcept { return Complexity::constant; }
+        [[nodiscard]] constexpr double get_rms() const noexcept { return 0; }
+        [[nodiscard]] ComplexityFit get_fit(Complexity) const noexcept { return fit; }
+    };
+#endif
+
+
+    // Outcome of a Comparison, for B relative to A.
+    enum class Verdict { faster, slower, indistinguishable };
+
+    constexpr std::string_view to_string(Verdict verdict) noexcept
+    {
+        switch (verdict) {
+            case Verdict::faster: return "faster";
+            case Verdict::slower: return "slower";
+            case Verdict::indistinguishable: return "indistinguishable";
+        }
+        return "indistinguishable";
+    }
+
+    namespace detail
+    {
+        inline double median_of(std::vector<int64_t>& samples) noexcept
+        {
+            if (samples.empty()) return 0;
+            std::size_t middle = samples.size() / 2;
+            std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
+            double upper = static_cast<double>(samples[middle]);
+            if (samples.size() & 1) return upper;
+            return (upper + static_cast<double>(*std::max_element(samples.begin(), samples.begin() + middle))) / 2;
+        }
+
+        // Mann-Whitney U p-value for two sets of samples.
+        inline double mann_whitney_p(const std::vector<int64_t>& a, const std::vector<int64_t>& b)
+        {
+            if (a.empty() || b.empty()) return 1.0;
+
+            std::vector<std::pair<int64_t, bool>> all; // sample, is from a
+            all.reserve(a.size() + b.size());
+            for (int64_t x : a) all.emplace_back(x, true);
+            for (int64_t x : b) all.emplace_back(x, false);
+            std::sort(all.begin(), all.end());
+
+            MannWhitney test;
+            for (std::size_t i = 0; i < all.size();) {
+                std::size_t j = i, from_a = 0;
+                for (; j < all.size() && all[j].first == all[i].first; ++j) from_a += all[j].second;
+                test.add_ties(static_cast<double>(from_a), static_cast<double>(j - i - from_a));
+                i = j;
+            }
+            return test.p_value();
+        }
+    } // namespace detail
+
+
+    // A/B comparison of two callables called with the same arguments. Calls are interleaved in
+    // ABBA order, so drift and thermal effects hit both sides equally. The speedup is
+    // median(A) / median(B), above 1 when B is faster, with a bootstrap confidence interval;
+    // B is only called faster or slower when the Mann-Whitney U test rejects equality at
+    // `alpha` and the interval excludes 1. The `record`, `histogram` and `baseline` settings
+    // are ignored, as they would mix both sides; use `get_samples_a()` and `get_samples_b()`.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class Comparison : public detail::BaseTimerFormatter
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t iterations = 30;       // calls of each callable
+            std::size_t resamples = 2000;      // bootstrap resamples
+            double confidence = 0.95;          // of the speedup interval
+            double alpha = 0.05;               // significance level of the U test
+            std::uint64_t seed = 0x5eed;       // bootstrap seed, for reproducible intervals
+        };
+
+    private:
+        Settings settings;
+        std::vector<int64_t> samples_a;
+        std::vector<int64_t> samples_b;
+        double speedup = 1;
+        std::pair<double, double> interval { 1, 1 };
+        double p_value = 1;
+        Verdict verdict = Verdict::indistinguishable;
+
+        template <typename Callable, typename... Args>
+        static int64_t time_call(const detail::BaseTimerSettings& timer_settings, Callable& function, Args&... args)
+        {
+            using Result = std::invoke_result_t<Callable&, Args&...>;
+            FunctionTimer<Result, duration, clock> timer(timer_settings, function, args...);
+            if constexpr (!std::is_void_v<Result>) do_not_optimize(timer.get_result());
+            return timer.get_elapsed();
+        }
+
+        void bootstrap()
+        {
+            std::mt19937_64 engine(settings.seed);
+            std::uniform_int_distribution<std::size_t> pick_a(0, samples_a.size() - 1);
+            std::uniform_int_distribution<std::size_t> pick_b(0, samples_b.size() - 1);
+            std::vector<int64_t> resample_a(samples_a.size()), resample_b(samples_b.size());
+            std::vector<double> ratios;
+            ratios.reserve(std::max<std::size_t>(settings.resamples, 1));
+
+            for (std::size_t i = 0; i < std::max<std::size_t>(settings.resamples, 1); ++i) {
+                for (auto& x : resample_a) x = samples_a[pick_a(engine)];
+                for (auto& x : resample_b) x = samples_b[pick_b(engine)];
+                double b = detail::median_of(resample_b);
+                ratios.push_back(b > 0 ? detail::median_of(resample_a) / b : 1.0);
+            }
+            std::sort(ratios.begin(), ratios.end());
+
+            double tail = (1 - std::clamp(settings.confidence, 0.0, 1.0)) / 2;
+            auto at = [&](double quantile) {
+                return ratios[static_cast<std::size_t>(quantile * static_cast<double>(ratios.size() - 1))];
+            };
+            interval = { at(tail), at(1 - tail) };
+        }
+
+    public:
+        Comparison(const Comparison&) = delete;
+        Comparison& operator=(const Comparison&) = delete;
+        Comparison(Comparison&&) = delete;
+        Comparison& operator=(Comparison&&) = delete;
+
+        template <typename A, typename B, typename... Args>
+        Comparison(Settings settings, A&& a, B&& b, Args&&... args) : settings(settings)
+        {
+            // one destination cannot tell A from B, so the timers do not feed any
+            detail::BaseTimerSettings timer_settings = this->settings;
+            timer_settings.show_output = false;
+            timer_settings.sample_every = 1;
+            timer_settings.record = false;
+            timer_settings.histogram = nullptr;
+            timer_settings.baseline = nullptr;
+
+            const std::size_t iterations = std::max<std::size_t>(this->settings.iterations, 2);
+            samples_a.reserve(iterations);
+            samples_b.reserve(iterations);
+            for (std::size_t i = 0; i < iterations; ++i) {
+                if (i & 1) {
+                    samples_b.push_back(time_call(timer_settings, b, args...));
+                    samples_a.push_back(time_call(timer_settings, a, args...));
+                } else {
+                    samples_a.push_back(time_call(timer_settings, a, args...));
+                    samples_b.push_back(time_call(timer_settings, b, args...));
+                }
+            }
+
+            std::vector<int64_t> a_copy = samples_a, b_copy = samples_b;
+            double median_b = detail::median_of(b_copy);
+            speedup = median_b > 0 ? detail::median_of(a_copy) / median_b : 1.0;
+            bootstrap();
+            p_value = detail::mann_whitney_p(samples_a, samples_b);
+
+            bool significant = p_value < this->settings.alpha;
+            if (significant && interval.first > 1) verdict = Verdict::faster;
+            else if (significant && interval.second < 1) verdict = Verdict::slower;
+        }
+
+        ~Comparison()
+        {
+            if (!settings.show_output) return;
+
+            DurationBuffer buffer;
+            auto ratio = [&](double value) {
+                auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value, std::chars_format::fixed, 3);
+                return std::string(buffer.data(), end) + "x";
+            };
+            std::string result = "B is " + std::string(to_string(verdict)) + ": " + ratio(speedup)
+                               + " [" + ratio(interval.first) + ", " + ratio(interval.second) + "], p = ";
+            auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), p_value, std::chars_format::general, 3);
+            result.append(buffer.data(), end);
+            write_output(result, settings);
+        }
+
+        // median(A) / median(B): above 1 when B is faster.
+        [[nodiscard]] double get_speedup() const noexcept { return speedup; }
+        [[nodiscard]] std::pair<double, double> get_confidence_interval() const noexcept { return interval; }
+        [[nodiscard]] double get_p_value() const noexcept { return p_value; }
+        [[nodiscard]] Verdict get_verdict() const noexcept { return verdict; }
+        // Per-call times in nanoseconds, in call order.
+        [[nodiscard]] const std::vector<int64_t>& get_samples_a() const noexcept { return samples_a; }
+        [[nodiscard]] const std::vector<int64_t>& get_samples_b() const noexcept { return samples_b; }
+    };
+#else
+    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
+    class Comparison
+    {
+    public:
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::size_t iterations = 30;
+            std::size_t resamples = 2000;
+            double confidence = 0.95;
+            double alpha = 0.05;
+            std::uint64_t seed = 0x5eed;
+        };
+
+    private:
+        std::vector<int64_t> samples;
+
+    public:
+        Comparison(const Comparison&) = delete;
+        Comparison& operator=(const Comparison&) = delete;
+        Comparison(Comparison&&) = delete;
+        Comparison& operator=(Comparison&&) = delete;
+
+        // calls each function once, so side effects are preserved
+        template <typename A, typename B, typename... Args>
+        Comparison(Settings, A&& a, B&& b, Args&&... args)
+        {
+            std::invoke(a, args...);
+            std::invoke(b, args...);
+        }
+
+        [[nodiscard]] constexpr double get_speedup() const noexcept { return 1; }
+        [[nodiscard]] constexpr std::pair<double, double> get_confidence_interval() const noexcept { return { 1, 1 }; }
+        [[nodiscard]] constexpr double get_p_value() const noexcept { return 1; }
+        [[nodiscard]] constexpr Verdict get_verdict() const noexcept { return Verdict::indistinguishable; }
+        [[nodiscard]] const std::vector<int64_t>& get_samples_a() const noexcept { return samples; }
+        [[nodiscard]] const std::vector<int64_t>& get_samples_b() const noexcept { return samples; }
+    };
+#endif
+
+
+    // Formats every record immediately and writes it to a stream, like the default
+    // `output_stream` path. The stream is flushed by `flush()` and on destruction; flushing
+    // after each record is opt-in.
+    class StreamSink : public Sink, protected detail::BaseTimerFormatter
+    {
+    private:
+        std::ostream& stream;
+        Format format;
+        bool flush_each;
+        std::mutex mutex;
+
+    public:
+        StreamSink(std::ostream& stream = std::cout, Format format = detail::BaseTimerSettings::default_format, bool flush_each = false) noexcept
+            : stream(stream), format(format), flush_each(flush_each)
+        {
+        }
+
+        ~StreamSink() override { flush(); }
+
+        StreamSink(const StreamSink&) = delete;
+        StreamSink& operator=(const StreamSink&) = delete;
+        StreamSink(StreamSink&&) = delete;
+        StreamSink& operator=(StreamSink&&) = delete;
+
+        void flush() noexcept
+        {
+            std::lock_guard lock(mutex);
+            stream.flush();
+        }
+
+        void write(const Record& record) noexcept override
+        {
+            DurationBuffer buffer;
+            std::lock_guard lock(mutex);
+            format.render(std::ostreambuf_iterator<char>(stream), record_fields(buffer, record));
+            stream.put('\n');
+            if (flush_each) stream.flush();
+        }
+    };
+
+
+    // Non-blocking sink: `write` pushes the record into a lock-free ring buffer owned by the
+    // calling thread, and a background thread formats the records and writes them in batches.
+    // Records that do not fit in a full ring are dropped and counted rather than blocking.
+    // Record names are referenced, not copied, so they must outlive the sink.
+    class AsyncSink : public Sink, protected detail::BaseTimerFormatter
+    {
+    public:
+        struct Options
+        {
+            std::size_t capacity = 4096; // records per thread, rounded up to a power of two
+            std::chrono::milliseconds interval { 10 }; // time between background flushes
+        };
+
+    private:
+        // Single producer (the owning thread), single consumer (whoever holds `drain_mutex`).
+        struct Ring
+        {
+            explicit Ring(std::size_t capacity) : records(std::bit_ceil(std::max<std::size_t>(capacity, 2))) {}
+
+            std::vector<Record> records;
+            alignas(64) std::atomic<std::size_t> head { 0 };
+            alignas(64) std::atomic<std::size_t> tail { 0 };
+        };
+
+        std::ostream& stream;
+        Format format;
+        Options options;
+        std::uint64_t id;
+
+        std::mutex rings_mutex;
+        std::unordered_map<std::thread::id, std::unique_ptr<Ring>> rings;
+
+        std::mutex drain_mutex;
+        std::vector<Ring*> draining; // rings being drained, under `drain_mutex`
+        std::string batch;
+        std::atomic<std::uint64_t> dropped_records { 0 };
+
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+        std::thread worker;
+
+        static std::uint64_t next_id() noexcept
+        {
+            static std::atomic<std::uint64_t> ids { 0 };
+            return ++ids;
+        }
+
+        Ring* local_ring() noexcept
+        {
+            // a few entries per thread, keyed by sink id so a new sink at the same address never
+            // hits, and a thread alternating between sinks only locks on its first record to each
+            struct CacheEntry { std::uint64_t sink = 0; Ring* ring = nullptr; };
+            thread_local std::array<CacheEntry, 8> cache {};
+            thread_local std::size_t next_entry = 0;
+            for (const CacheEntry& entry : cache)
+                if (entry.sink == id) return entry.ring;
+
+            std::lock_guard lock(rings_mutex);
+            auto& ring = rings[std::this_thread::get_id()];
+            if (!ring) {
+                try { ring = std::make_unique<Ring>(options.capacity); }
+                catch (...) { return nullptr; }
+            }
+            cache[next_entry++ % cache.size()] = { id, ring.get() };
+            return ring.get();
+        }
+
+        void drain() noexcept
+        {
+            std::lock_guard lock(drain_mutex);
+            {
+                // rings are never freed before the sink, so only the list needs `rings_mutex`:
+                // a thread registering its ring never waits for the formatting
+                std::lock_guard rings_lock(rings_mutex);
+                try { draining.resize(rings.size()); }
+                catch (...) { return; }
+                std::transform(rings.begin(), rings.end(), draining.begin(), [](const auto& entry) { return entry.second.get(); });
+            }
+            for (Ring* ring : draining) {
+                std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+                std::size_t head = ring->head.load(std::memory_order_acquire);
+                std::size_t mask = ring->records.size() - 1;
+                for (; tail != head; ++tail) {
+                    DurationBuffer buffer;
+                    format.render(std::back_inserter(batch), record_fields(buffer, ring->records[tail & mask]));
+                    batch.push_back('\n');
+                }
+                ring->tail.store(tail, std::memory_order_release);
+            }
+            if (batch.empty()) return;
+
+            stream.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            stream.flush();
+            batch.clear();
+        }
+
+        void run() noexcept
+        {
+            std::unique_lock lock(wake_mutex);
+            while (!stopping) {
+                wake.wait_for(lock, options.interval, [this] { return stopping; });
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        }
+
+    public:
+        AsyncSink(std::ostream& stream, Format format, Options options)
+            : stream(stream), format(format), options(options), id(next_id())
+        {
+            worker = std::thread([this] { run(); });
+        }
+
+        AsyncSink(std::ostream& stream = std::cout, Format format = detail::BaseTimerSettings::default_format)
+            : AsyncSink(stream, format, Options {})
+        {
+        }
+
+        ~AsyncSink() override
+        {
+            {
+                std::lock_guard lock(wake_mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+            drain();
+        }
+
+        AsyncSink(const AsyncSink&) = delete;
+        AsyncSink& operator=(const AsyncSink&) = delete;
+        AsyncSink(AsyncSink&&) = delete;
+        AsyncSink& operator=(AsyncSink&&) = delete;
+
+        void write(const Record& record) noexcept override
+        {
+            Ring* ring = local_ring();
+            if (!ring) {
+                dropped_records.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            std::size_t head = ring->head.load(std::memory_order_relaxed);
+            if (head - ring->tail.load(std::memory_order_acquire) == ring->records.size()) {
+                dropped_records.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            ring->records[head & (ring->records.size() - 1)] = record;
+            ring->head.store(head + 1, std::memory_order_release);
+        }
+
+        // Synchronously format and write everything recorded so far.
+        void flush() noexcept { drain(); }
+
+        [[nodiscard]] std::uint64_t get_dropped() const noexcept { return dropped_records.load(std::memory_order_relaxed); }
+    };
+
+
+    // Collects records as timeline spans and writes them as Chrome Trace Event JSON, which
+    // chrome://tracing and ui.perfetto.dev both open. Every thread buffer is allocated at
+    // construction and claimed lock-free on a thread's first record, so recording never
+    // allocates nor locks; records beyond a full buffer, or from too many threads, are dropped.
+    class TraceSink : public Sink
+    {
+    public:
+        struct Options
+        {
+            std::size_t threads = 16;               // thread buffers
+            std::size_t events_per_thread = 16384;  // records per thread buffer
+        };
+
+    private:
+        struct alignas(64) ThreadBuffer
+        {
+            std::atomic<std::thread::id> owner {};
+            std::atomic<std::size_t> size { 0 };
+            std::unique_ptr<Record[]> events;
+        };
+
+        Options options;
+        std::uint64_t id;
+        std::unique_ptr<ThreadBuffer[]> buffers;
+        std::atomic<std::size_t> claimed { 0 };
+        std::atomic<std::uint64_t> dropped_records { 0 };
+        std::string path;
+
+        static std::uint64_t next_id() noexcept
+        {
+            static std::atomic<std::uint64_t> ids { 0 };
+            return ++ids;
+        }
+
+        ThreadBuffer* local_buffer() noexcept
+        {
+            thread_local struct { std::uint64_t sink = 0; ThreadBuffer* buffer = nullptr; } cache;
+            if (cache.sink == id) return cache.buffer;
+
+            // a thread switching between sinks finds its buffer again instead of claiming another
+            const auto self = std::this_thread::get_id();
+            std::size_t count = std::min(claimed.load(std::memory_order_acquire), options.threads);
+            for (std::size_t i = 0; i < count; ++i) {
+                if (buffers[i].owner.load(std::memory_order_relaxed) == self) {
+                    cache = { id, &buffers[i] };
+                    return cache.buffer;
+                }
+            }
+
+            std::size_t index = claimed.fetch_add(1, std::memory_order_acq_rel);
+            if (index >= options.threads) return nullptr;
+            buffers[index].owner.store(self, std::memory_order_relaxed);
+            cache = { id, &buffers[index] };
+            return cache.buffer;
+        }
+
+        static void write_microseconds(std::ostream& stream, int64_t ns)
+        {
+            char buffer[32];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(ns) / 1000.0, std::chars_format::fixed, 3);
+            stream.write(buffer, end - buffer);
+        }
+
+    public:
+        TraceSink(std::string path, Options options)
+            : options(options), id(next_id()), buffers(std::make_unique<ThreadBuffer[]>(options.threads)), path(std::move(path))
+        {
+            for (std::size_t i = 0; i < options.threads; ++i)
+                buffers[i].events = std::make_unique<Record[]>(options.events_per_thread);
+        }
+
+        // An empty path only records; call `write_json` to export.
+        explicit TraceSink(std::string path = {}) : TraceSink(std::move(path), Options {}) {}
+
+        // Writes the trace to the path given at construction, if any.
+        ~TraceSink() override
+        {
+            if (path.empty()) return;
+            std::ofstream file(path, std::ios::binary);
+            if (file) write_json(file);
+        }
+
+        TraceSink(const TraceSink&) = delete;
+        TraceSink& operator=(const TraceSink&) = delete;
+        TraceSink(TraceSink&&) = delete;
+        TraceSink& operator=(TraceSink&&) = delete;
+
+        void write(const Record& record) noexcept override
+        {
+            ThreadBuffer* buffer = local_buffer();
+            std::size_t size = buffer ? buffer->size.load(std::memory_order_relaxed) : options.events_per_thread;
+            if (size == options.events_per_thread) {
+                dropped_records.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            buffer->events[size] = record;
+            buffer->size.store(size + 1, std::memory_order_release);
+        }
+
+        // Write every span recorded so far as complete ("X") events, one tid per thread buffer.
+        void write_json(std::ostream& stream) const
+        {
+            stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+            bool first = true;
+            std::size_t count = std::min(claimed.load(std::memory_order_acquire), options.threads);
+            for (std::size_t thread = 0; thread < count; ++thread) {
+                const ThreadBuffer& buffer = buffers[thread];
+                std::size_t size = buffer.size.load(std::memory_order_acquire);
+                for (std::size_t i = 0; i < size; ++i) {
+                    const Record& event = buffer.events[i];
+                    stream << (first ? "\n" : ",\n") << "{\"name\":\"";
+                    detail::write_escaped(stream, event.name);
+                    stream << "\",\"cat\":\"timed\",\"ph\":\"X\",\"ts\":";
+                    write_microseconds(stream, event.start);
+                    stream << ",\"dur\":";
+                    write_microseconds(stream, event.get_elapsed());
+                    stream << ",\"pid\":1,\"tid\":" << thread + 1 << ",\"args\":{\"file\":\"";
+                    detail::write_escaped(stream, event.location.file_name());
+                    stream << "\",\"line\":" << event.location.line() << ",\"function\":\"";
+                    detail::write_escaped(stream, event.location.function_name());
+                    stream << "\"}}";
+                    first = false;
+                }
+            }
+            stream << "\n]}\n";
+            stream.flush();
+        }
+
+        [[nodiscard]] std::uint64_t get_dropped() const noexcept { return dropped_records.load(std::memory_order_relaxed); }
+    };
+
+
+    // Background metrics scrape for long-running services: every `interval`, a thread collects
+    // the Registry and the listed histograms, which resets their window, and writes one row per
+    // site active in the window (count, rate, p50, p99 and max) to `output_stream`, either as
+    // a table or as JSON lines. Recorders are never blocked; the reporter owns the window, so
+    // Registry::snapshot() only covers the time since the last report. A last report is written
+    // on destruction.
+#if TIMED_ENABLED
+    template <detail::Duration duration = automatic_duration>
+    class Reporter : protected detail::BaseTimerFormatter
+    {
+    public:
+        enum class Style { table, json_lines };
+
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::chrono::milliseconds interval { 10000 };
+            Style style = Style::table;
+            // reported under their name next to the Registry sites
+            std::vector<std::pair<std::string_view, Histogram*>> histograms;
+        };
+
+    private:
+        struct Row
+        {
+            std::string_view name;
+            std::string_view file;
+            std::uint_least32_t line = 0;
+            std::uint64_t count = 0;
+            int64_t p50 = 0;
+            int64_t p99 = 0;
+            int64_t max = 0;
+        };
+
+        Settings settings;
+        std::chrono::steady_clock::time_point window_start = std::chrono::steady_clock::now();
+        std::mutex report_mutex;
+        std::uint64_t reports = 0;
+
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+        std::thread worker;
+
+        void run() noexcept
+        {
+            std::unique_lock lock(wake_mutex);
+            while (!stopping) {
+                if (wake.wait_for(lock, settings.interval, [this] { return stopping; })) break;
+                lock.unlock();
+                report();
+                lock.lock();
+            }
+        }
+
+        void write_table(const std::vector<Row>& rows, double seconds)
+        {
+            std::size_t width = 4;
+            for (const Row& row : rows) width = std::max(width, row.name.size());
+
+            std::ostream& out = settings.output_stream;
+            char number[32];
+            auto [end, ec] = std::to_chars(number, number + sizeof(number), seconds, std::chars_format::fixed, 2);
+            if (!settings.name.empty()) out << '[' << settings.name << "] ";
+            out << "interval " << std::string_view(number, static_cast<std::size_t>(end - number)) << " s\n";
+
+            auto cell = [&](std::string_view text, std::size_t size, bool left = false) {
+                if (left) out << text;
+                for (std::size_t i = text.size(); i < size; ++i) out.put(' ');
+                if (!left) out << text;
+            };
+            cell("site", width, true);
+            cell("count", 12); cell("rate/s", 14); cell("p50", 14); cell("p99", 14); cell("max", 14);
+            out << '\n';
+            for (const Row& row : rows) {
+                DurationBuffer buffer;
+                cell(row.name, width, true);
+                cell(std::to_string(row.count), 12);
+                cell(std::to_string(static_cast<std::uint64_t>(static_cast<double>(row.count) / seconds)), 14);
+                cell(duration_to_chars<duration>(buffer, row.p50), 14);
+                cell(duration_to_chars<duration>(buffer, row.p99), 14);
+                cell(duration_to_chars<duration>(buffer, row.max), 14);
+                out << '\n';
+            }
+            out.flush();
+        }
+
+        void write_json_lines(const std::vector<Row>& rows, double seconds)
+        {
+            std::ostream& out = settings.output_stream;
+            auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            char number[32];
+            for (const Row& row : rows) {
+                out << "{\"timestamp_ms\":" << timestamp << ",\"interval_s\":";
+                auto [end, ec] = std::to_chars(number, number + sizeof(number), seconds, std::chars_format::fixed, 3);
+                out.write(number, end - number);
+                out << ",\"name\":\"";
+                detail::write_escaped(out, row.name);
+                out << '"';
+                if (!row.file.empty()) {
+                    out << ",\"file\":\"";
+                    detail::write_escaped(out, row.file);
+                    out << "\",\"line\":" << row.line;
+                }
+                auto [rate_end, rate_ec] = std::to_chars(number, number + sizeof(number), static_cast<double>(row.count) / seconds, std::chars_format::fixed, 1);
+                out << ",\"count\":" << row.count << ",\"rate\":";
+                out.write(number, rate_end - number);
+                out << ",\"p50_ns\":" << row.p50 << ",\"p99_ns\":" << row.p99 << ",\"max_ns\":" << row.max << "}\n";
+            }
+            out.flush();
+        }
+
+    public:
+        Reporter(const Reporter&) = delete;
+        Reporter& operator=(const Reporter&) = delete;
+        Reporter(Reporter&&) = delete;
+        Reporter& operator=(Reporter&&) = delete;
+
+        explicit Reporter(Settings settings) : settings(std::move(settings))
+        {
+            worker = std::thread([this] { run(); });
+        }
+
+        ~Reporter()
+        {
+            {
+                std::lock_guard lock(wake_mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+            report();
+        }
+
+        // Collect and write the current window now, restarting it.
+        void report() noexcept
+        {
+            try {
+                std::lock_guard lock(report_mutex);
+                auto now = std::chrono::steady_clock::now();
+                double seconds = std::max(std::chrono::duration<double>(now - window_start).count(), 1e-9);
+                window_start = now;
+
+                std::vector<Row> rows;
+                for (const Registry::Summary& summary : Registry::collect()) {
+                    if (summary.count == 0) continue;
+                    rows.push_back({ summary.name, summary.location.file_name(), summary.location.line(), summary.count,
+                                     summary.get_percentile(0.5), summary.get_percentile(0.99), summary.max });
+                }
+                for (auto& [name, histogram] : settings.histograms) {
+                    if (!histogram) continue;
+                    Histogram::Snapshot window = histogram->collect();
+                    if (window.get_count() == 0) continue;
+                    rows.push_back({ name, {}, 0, window.get_count(), window.get_percentile(0.5),
+                                     window.get_percentile(0.99), window.get_max() });
+                }
+
+                ++reports;
+                if (!settings.show_output || rows.empty()) return;
+                if (settings.style == Style::json_lines) write_json_lines(rows, seconds);
+                else write_table(rows, seconds);
+            } catch (...) {}
+        }
+
+        [[nodiscard]] std::uint64_t get_reports() noexcept
+        {
+            std::lock_guard lock(report_mutex);
+            return reports;
+        }
+    };
+#else
+    template <detail::Duration duration = automatic_duration>
+    class Reporter
+    {
+    public:
+        enum class Style { table, json_lines };
+
+        struct Settings : public detail::BaseTimerSettings
+        {
+            std::chrono::milliseconds interval { 10000 };
+            Style style = Style::table;
+            std::vector<std::pair<std::string_view, Histogram*>> histograms;
+        };
+
+        Reporter(const Reporter&) = delete;
+        Reporter& operator=(const Reporter&) = delete;
+        Reporter(Reporter&&) = delete;
+        Reporter& operator=(Reporter&&) = delete;
+
+        explicit Reporter(Settings) noexcept {}
+
+        void report() noexcept {}
+        [[nodiscard]] constexpr std::uint64_t get_reports() const noexcept { return 0; }
+    };
+#endif
+
+
+    namespace detail
+    {
+        // Escape a Prometheus label value: backslash, double quote and newline.
+        inline void write_label_value(std::ostream& stream, std::string_view text)
+        {
+            for (char c : text) {
+                switch (c) {
+                case '\\': stream << "\\\\"; break;
+                case '"':  stream << "\\\""; break;
+                case '\n': stream << "\\n"; break;
+                default:   stream.put(c);
+                }
+            }
+        }
+
+        // Registry bucket i holds samples below 2^i ns; these are the `le` bounds exported,
+        // 16 ns to ~69 s, fixed so that every scrape has the same series.
+        inline constexpr std::size_t prometheus_first_bucket = 4;
+        inline constexpr std::size_t prometheus_last_bucket = 36;
+    } // namespace detail
+
+
+    // Prometheus text exposition (format 0.0.4) of registry summaries: one histogram family
+    // `<prefix>_duration_seconds` with `_bucket`, `_sum` and `_count` series per site, labelled
+    // by name, file, line and function. Registry::snapshot() is cumulative as Prometheus expects,
+    // unless a Reporter is resetting it.
+    inline void write_prometheus(std::ostream& stream, const std::vector<Registry::Summary>& summaries, std::string_view prefix = "timed")
+    {
+        stream << "# HELP " << prefix << "_duration_seconds Durations measured by Timed++ timers.\n"
+               << "# TYPE " << prefix << "_duration_seconds histogram\n";
+        char number[32];
+        auto seconds = [&](double ns) {
+            auto [end, ec] = std::to_chars(number, number + sizeof(number), ns / 1e9);
+            return std::string_view(number, static_cast<std::size_t>(end - number));
+        };
+
+        for (const Registry::Summary& summary : summaries) {
+            auto labels = [&] {
+                stream << "name=\"";
+                detail::write_label_value(stream, summary.name);
+                stream << "\",file=\"";
+                detail::write_label_value(stream, summary.location.file_name());
+                stream << "\",line=\"" << summary.location.line() << "\",function=\"";
+                detail::write_label_value(stream, summary.location.function_name());
+                stream << '"';
+            };
+
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < detail::prometheus_first_bucket; ++i) cumulative += summary.buckets[i];
+            for (std::size_t i = detail::prometheus_first_bucket; i <= detail::prometheus_last_bucket; ++i) {
+                cumulative += summary.buckets[i];
+                stream << prefix << "_duration_seconds_bucket{";
+                labels();
+                stream << ",le=\"" << seconds(static_cast<double>(std::uint64_t(1) << i)) << "\"} " << cumulative << '\n';
+            }
+            stream << prefix << "_duration_seconds_bucket{";
+            labels();
+            stream << ",le=\"+Inf\"} " << summary.count << '\n';
+            stream << prefix << "_duration_seconds_sum{";
+            labels();
+            stream << "} " << seconds(static_cast<double>(summary.sum)) << '\n';
+            stream << prefix << "_duration_seconds_count{";
+            labels();
+            stream << "} " << summary.count << '\n';
+        }
+    }
+
+
+#if TIMED_HAS_SOCKETS
+    // Minimal HTTP endpoint serving `write_prometheus(Registry::snapshot())` on `GET /metrics`.
+    // The snapshot is taken on the exporter's thread when scraped, never on the recording path.
+    // One connection is served at a time, which is all a scraper needs.
+#if TIMED_ENABLED
+    class PrometheusExporter
+    {
+    public:
+        struct Options
+        {
+            std::uint16_t port = 9464;       // 0 picks a free port, see `get_port()`
+            bool any_address = false;        // listen on every interface instead of loopback only
+            std::string prefix = "timed";
+        };
+
+    private:
+        Options options;
+        int listener = -1;
+        std::uint16_t port = 0;
+        std::atomic<bool> stopping { false };
+        std::thread worker;
+
+        void serve(int connection) noexcept
+        {
+            try {
+                // the request line is enough: anything but GET /metrics is a 404
+                char request[1024];
+                ssize_t size = 0;
+                while (size < static_cast<ssize_t>(sizeof(request))) {
+                    pollfd ready { connection, POLLIN, 0 };
+                    if (poll(&ready, 1, 1000) <= 0) break;
+                    ssize_t got = recv(connection, request + size, sizeof(request) - static_cast<std::size_t>(size), 0);
+                    if (got <= 0) break;
+                    size += got;
+                    if (std::string_view(request, static_cast<std::size_t>(size)).find("\r\n\r\n") != std::string_view::npos) break;
+                }
+                std::string_view line(request, static_cast<std::size_t>(std::max<ssize_t>(size, 0)));
+                bool metrics = line.starts_with("GET /metrics ") || line.starts_with("GET /metrics?");
+
+                std::ostringstream body;
+                if (metrics) write_prometheus(body, Registry::snapshot(), options.prefix);
+                std::string content = body.str();
+
+                std::string response = metrics ? "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                               : "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n";
+                response += "Content-Length: " + std::to_string(content.size()) + "\r\nConnection: close\r\n\r\n";
+                response += content;
+
+                for (std::size_t sent = 0; sent < response.size();) {
+                    ssize_t wrote = send(connection, response.data() + sent, response.size() - sent, TIMED_SEND_FLAGS);
+                    if (wrote <= 0) break;
+                    sent += static_cast<std::size_t>(wrote);
+                }
+            } catch (...) {}
+            close(connection);
+        }
+
+        void run() noexcept
+        {
+            while (!stopping.load(std::memory_order_relaxed)) {
+                pollfd ready { listener, POLLIN, 0 };
+                if (poll(&ready, 1, 100) <= 0) continue;
+                int connection = accept(listener, nullptr, nullptr);
+                if (connection >= 0) serve(connection);
+            }
+        }
+
+    public:
+        explicit PrometheusExporter(Options options) : options(std::move(options))
+        {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            if (listener < 0) return;
+            int reuse = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in address {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(this->options.port);
+            address.sin_addr.s_addr = htonl(this->options.any_address ? INADDR_ANY : INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0 ||
+                getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+                close(listener);
+                listener = -1;
+                return;
+            }
+            port = ntohs(address.sin_port);
+            worker = std::thread([this] { run(); });
+        }
+
+        PrometheusExporter() : PrometheusExporter(Options {}) {}
+
+        ~PrometheusExporter()
+        {
+            stopping.store(true, std::memory_order_relaxed);
+            if (worker.joinable()) worker.join();
+            if (listener >= 0) close(listener);
+        }
+
+        PrometheusExporter(const PrometheusExporter&) = delete;
+        PrometheusExporter& operator=(const PrometheusExporter&) = delete;
+        PrometheusExporter(PrometheusExporter&&) = delete;
+        PrometheusExporter& operator=(PrometheusExporter&&) = delete;
+
+        // False when the port could not be bound.
+        [[nodiscard]] bool is_open() const noexcept { return listener >= 0; }
+        [[nodiscard]] std::uint16_t get_port() const noexcept { return port; }
+    };
+
+
+    // Sends registry deltas to a StatsD daemon over UDP every `interval`, from a background
+    // thread. Per site and window: `<prefix>.<name>.count` as a counter and `.avg`, `.p50` and
+    // `.p99` as gauges in milliseconds; names are sanitized to [A-Za-z0-9_.-]. Lines are packed
+    // into datagrams of at most `max_datagram` bytes. With `tags`, the source location is
+    // attached as DogStatsD tags. Deltas are taken from cumulative snapshots, so the Registry
+    // is not reset; when something else resets it (Registry::collect(), a Reporter), a site
+    // whose counters went down sends its current counts instead, and what that reset took is
+    // not sent.
+    class StatsdExporter
+    {
+    public:
+        struct Options
+        {
+            std::string host = "127.0.0.1";  // numeric IPv4 address
+            std::uint16_t port = 8125;
+            std::chrono::milliseconds interval { 10000 };
+            std::string prefix = "timed";
+            std::size_t max_datagram = 1432; // fits an Ethernet MTU with IPv4/UDP headers
+            bool tags = false;
+        };
+
+    private:
+        Options options;
+        int socket_fd = -1;
+        sockaddr_in address {};
+        std::vector<Registry::Summary> previous;
+        std::string datagram;
+        std::mutex flush_mutex;
+
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+        std::thread worker;
+
+        void send_datagram() noexcept
+        {
+            if (datagram.empty()) return;
+            sendto(socket_fd, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            datagram.clear();
+        }
+
+        void append(const std::string& line)
+        {
+            if (!datagram.empty() && datagram.size() + 1 + line.size() > options.max_datagram) send_datagram();
+            if (!datagram.empty()) datagram.push_back('\n');
+            datagram += line;
+        }
+
+        std::string metric_name(const Registry::Summary& summary) const
+        {
+            std::string name = options.prefix;
+            if (!name.empty()) name.push_back('.');
+            for (char c : summary.name) {
+                bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+                name.push_back(allowed ? c : '_');
+            }
+            return name;
+        }
+
+        std::string tag_suffix(const Registry::Summary& summary) const
+        {
+            if (!options.tags) return {};
+            std::string file(summary.location.file_name());
+            for (char& c : file) if (c == ',' || c == '|' || c == '#') c = '_';
+            return "|#file:" + file + ",line:" + std::to_string(summary.location.line());
+        }
+
+        // Registry::collect(), e.g. from a Reporter, zeroes the counters: any of them going down
+        // means the site restarted, and all of the current counts are new.
+        static bool was_reset(const Registry::Summary& previous, const Registry::Summary& current) noexcept
+        {
+            if (current.count < previous.count) return true;
+            for (std::size_t b = 0; b < Registry::bucket_count; ++b)
+                if (current.buckets[b] < previous.buckets[b]) return true;
+            return false;
+        }
+
+        void run() noexcept
+        {
+            std::unique_lock lock(wake_mutex);
+            while (!stopping) {
+                if (wake.wait_for(lock, options.interval, [this] { return stopping; })) break;
+                lock.unlock();
+                flush();
+                lock.lock();
+            }
+        }
+
+    public:
+        explicit StatsdExporter(Options options) : options(std::move(options))
+        {
+            address.sin_family = AF_INET;
+            address.sin_port = htons(this->options.port);
+            if (inet_pton(AF_INET, this->options.host.c_str(), &address.sin_addr) != 1) return;
+            socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+            if (socket_fd < 0) return;
+            previous = Registry::snapshot();
+            worker = std::thread([this] { run(); });
+        }
+
+        StatsdExporter() : StatsdExporter(Options {}) {}
+
+        // Stops the thread and sends the last window.
+        ~StatsdExporter()
+        {
+            {
+                std::lock_guard lock(wake_mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            if (worker.joinable()) worker.join();
+            flush();
+            if (socket_fd >= 0) close(socket_fd);
+        }
+
+        StatsdExporter(const StatsdExporter&) = delete;
+        StatsdExporter& operator=(const StatsdExporter&) = delete;
+        StatsdExporter(StatsdExporter&&) = delete;
+        StatsdExporter& operator=(StatsdExporter&&) = delete;
+
+        // Send what was recorded since the last flush now.
+        void flush() noexcept
+        {
+            if (socket_fd < 0) return;
+            try {
+                std::lock_guard lock(flush_mutex);
+                std::vector<Registry::Summary> current = Registry::snapshot();
+                char number[32];
+                auto milliseconds = [&](int64_t ns) {
+                    auto [end, ec] = std::to_chars(number, number + sizeof(number), static_cast<double>(ns) / 1e6, std::chars_format::fixed, 6);
+                    return std::string(number, end);
+                };
+
+                // sites are only ever appended, so index i names the same site in both snapshots
+                for (std::size_t i = 0; i < current.size(); ++i) {
+                    Registry::Summary window = current[i];
+                    if (i < previous.size() && !was_reset(previous[i], current[i])) {
+                        window.count -= previous[i].count;
+                        window.sum -= previous[i].sum;
+                        for (std::size_t b = 0; b < Registry::bucket_count; ++b) window.buckets[b] -= previous[i].buckets[b];
+                    }
+                    if (window.count == 0) continue;
+
+                    std::string name = metric_name(window);
+                    std::string tags = tag_suffix(window);
+                    append(name + ".count:" + std::to_string(window.count) + "|c" + tags);
+                    append(name + ".avg:" + milliseconds(window.get_average()) + "|g" + tags);
+                    append(name + ".p50:" + milliseconds(window.get_percentile(0.5)) + "|g" + tags);
+                    append(name + ".p99:" + milliseconds(window.get_percentile(0.99)) + "|g" + tags);
+                }
+                send_datagram();
+                previous = std::move(current);
+            } catch (...) {}
+        }
+
+        // False when the host is not a numeric IPv4 address or no socket could be created.
+        [[nodiscard]] bool is_open() const noexcept { return socket_fd >= 0; }
+    };
+#else
+    class PrometheusExporter
+    {
+    public:
+        struct Options
+        {
+            std::uint16_t port = 9464;
+            bool any_address = false;
+            std::string prefix = "timed";
+        };
+
+        explicit PrometheusExporter(Options) noexcept {}
+        PrometheusExporter() noexcept {}
+        PrometheusExporter(const PrometheusExporter&) = delete;
+        PrometheusExporter& operator=(const PrometheusExporter&) = delete;
+
+        [[nodiscard]] constexpr bool is_open() const noexcept { return false; }
+        [[nodiscard]] constexpr std::uint16_t get_port() const noexcept { return 0; }
+    };
+
+    class StatsdExporter
+    {
+    public:
+        struct Options
+        {
+            std::string host = "127.0.0.1";
+            std::uint16_t port = 8125;
+            std::chrono::milliseconds interval { 10000 };
+            std::string prefix = "timed";
+            std::size_t max_datagram = 1432;
+            bool tags = false;
+        };
+
+        explicit StatsdExporter(Options) noexcept {}
+        StatsdExporter() noexcept {}
+        StatsdExporter(const StatsdExporter&) = delete;
+        StatsdExporter& operator=(const StatsdExporter&) = delete;
+
+        void flush() noexcept {}
+        [[nodiscard]] constexpr bool is_open() const noexcept { return false; }
+    };
+#endif
+#endif // TIMED_HAS_SOCKETS
+
+
+#if TIMED_HAS_MMAP
+    namespace detail
+    {
+        // Layout shared by BinaryWriter and BinaryReader. After an 8-byte magic, the file is a
+        // sequence of chunks: a type byte, a varint payload size and the payload.
+        //  - site:    varint id, then name, file and function as varint size + bytes, varint line, column
+        //  - block:   varint count, varint sizes of the first two columns, then three columns of
+        //             `count` varints: site ids, zigzag start deltas (chained across blocks), durations
+        //  - summary: varint site, varint scale (units per ns), count, zigzag sum/min/max, varint
+        //             non-empty buckets, (index, count) pairs
+        // Version 1 files ("TIMEDBN1") have no summary scale; their summaries are in ns.
+        namespace binary
+        {
+            constexpr std::string_view magic = "TIMEDBN2";
+            constexpr std::string_view magic_v1 = "TIMEDBN1";
+            enum class Chunk : std::uint8_t { site = 1, block = 2, summary = 3 };
+
+            inline void put_varint(std::string& out, std::uint64_t value)
+            {
+                while (value >= 0x80) {
+                    out.push_back(static_cast<char>(value | 0x80));
+                    value >>= 7;
+                }
+                out.push_back(static_cast<char>(value));
+            }
+
+            inline void put_zigzag(std::string& out, int64_t value)
+            {
+                put_varint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+            }
+
+            inline void put_string(std::string& out, std::string_view text)
+            {
+                put_varint(out, text.size());
+                out.append(text);
+            }
+
+            // Decoders stop at `end`; a truncated file reads as zeros rather than overrunning.
+            inline std::uint64_t get_varint(const char*& at, const char* end) noexcept
+            {
+                std::uint64_t value = 0;
+                for (unsigned shift = 0; at < end && shift < 64; shift += 7) {
+                    auto byte = static_cast<unsigned char>(*at++);
+                    value |= std::uint64_t(byte & 0x7f) << shift;
+                    if (!(byte & 0x80)) break;
+                }
+                return value;
+            }
+
+            inline int64_t get_zigzag(const char*& at, const char* end) noexcept
+            {
+                std::uint64_t value = get_varint(at, end);
+                return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+            }
+
+            inline std::string_view get_string(const char*& at, const char* end) noexcept
+            {
+                auto size = static_cast<std::size_t>(std::min<std::uint64_t>(get_varint(at, end), static_cast<std::uint64_t>(end - at)));
+                std::string_view text(at, size);
+                at += size;
+                return text;
+            }
+        } // namespace binary
+    } // namespace detail
+
+
+    // Compact binary results file, appended through a growing memory mapping. Sites are
+    // interned once into a string table; records are buffered into columnar blocks of
+    // delta-encoded start times and varint durations. Usable as a Sink, and also stores
+    // Registry snapshots. Only available where mmap is (POSIX).
+    class BinaryWriter : public Sink
+    {
+    public:
+        struct Options
+        {
+            std::size_t block_size = 4096;              // records per columnar block
+            std::size_t initial_capacity = 1 << 20;     // bytes mapped up front, doubled as needed
+        };
+
+    private:
+        Options options;
+        int fd = -1;
+        char* map = nullptr;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+
+        std::mutex mutex;
+        std::unordered_map<detail::SiteKey, std::uint32_t, detail::SiteKeyHash> sites;
+        std::deque<std::string> names; // interned names, referenced by the keys of `sites`
+
+        std::vector<std::uint32_t> pending_sites;
+        std::vector<int64_t> pending_starts;
+        std::vector<int64_t> pending_durations;
+        int64_t last_start = 0;
+        std::string chunk, columns[3];
+
+        bool reserve(std::size_t bytes) noexcept
+        {
+            if (size + bytes <= capacity) return true;
+
+            std::size_t grown = std::max(capacity * 2, size + bytes);
+            if (map) munmap(map, capacity);
+            map = nullptr;
+            if (ftruncate(fd, static_cast<off_t>(grown)) != 0) return false;
+            void* mapped = mmap(nullptr, grown, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) return false;
+            map = static_cast<char*>(mapped);
+            capacity = grown;
+            return true;
+        }
+
+        void append(std::string_view bytes) noexcept
+        {
+            if (fd < 0 || !reserve(bytes.size())) return;
+            std::memcpy(map + size, bytes.data(), bytes.size());
+            size += bytes.size();
+        }
+
+        void append_chunk(detail::binary::Chunk type, std::string_view payload)
+        {
+            std::string header(1, static_cast<char>(type));
+            detail::binary::put_varint(header, payload.size());
+            append(header);
+            append(payload);
+        }
+
+        std::uint32_t intern(std::string_view name, const std::source_location& location)
+        {
+            detail::SiteKey key { location.file_name(), location.line(), location.column(), name };
+            if (auto it = sites.find(key); it != sites.end()) return it->second;
+
+            auto id = static_cast<std::uint32_t>(sites.size());
+            key.name = names.emplace_back(name);
+            sites.emplace(key, id);
+
+            chunk.clear();
+            detail::binary::put_varint(chunk, id);
+            detail::binary::put_string(chunk, name);
+            detail::binary::put_string(chunk, location.file_name());
+            detail::binary::put_string(chunk, location.function_name());
+            detail::binary::put_varint(chunk, location.line());
+            detail::binary::put_varint(chunk, location.column());
+            append_chunk(detail::binary::Chunk::site, chunk);
+            return id;
+        }
+
+        void flush_block()
+        {
+            if (pending_sites.empty()) return;
+
+            for (auto& column : columns) column.clear();
+            for (std::size_t i = 0; i < pending_sites.size(); ++i) {
+                detail::binary::put_varint(columns[0], pending_sites[i]);
+                detail::binary::put_zigzag(columns[1], pending_starts[i] - last_start);
+                detail::binary::put_varint(columns[2], static_cast<std::uint64_t>(std::max<int64_t>(pending_durations[i], 0)));
+                last_start = pending_starts[i];
+            }
+
+            chunk.clear();
+            detail::binary::put_varint(chunk, pending_sites.size());
+            detail::binary::put_varint(chunk, columns[0].size());
+            detail::binary::put_varint(chunk, columns[1].size());
+            for (const auto& column : columns) chunk.append(column);
+            append_chunk(detail::binary::Chunk::block, chunk);
+
+            pending_sites.clear();
+            pending_starts.clear();
+            pending_durations.clear();
+        }
+
+    public:
+        BinaryWriter(const std::string& path, Options options) : options(options)
+        {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) return;
+            if (!reserve(std::max(options.initial_capacity, detail::binary::magic.size()))) {
+                ::close(fd);
+                fd = -1;
+                return;
+            }
+            append(detail::binary::magic);
+            pending_sites.reserve(options.block_size);
+            pending_starts.reserve(options.block_size);
+            pending_durations.reserve(options.block_size);
+        }
+
+        explicit BinaryWriter(const std::string& path) : BinaryWriter(path, Options {}) {}
 
-    namespace detail
-    {
-        template <typename T>
-        concept Duration = std::is_base_of_v<std::chrono::duration<typename T::rep, typename T::period>, T>
-                        || std::same_as<T, automatic_duration>;
+        ~BinaryWriter() override
+        {
+            if (fd < 0) return;
+            flush();
+            if (map) munmap(map, capacity);
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {}
+            ::close(fd);
+        }
 
+        BinaryWriter(const BinaryWriter&) = delete;
+        BinaryWriter& operator=(const BinaryWriter&) = delete;
+        BinaryWriter(BinaryWriter&&) = delete;
+        BinaryWriter& operator=(BinaryWriter&&) = delete;
 
-        constexpr int64_t ns_in_us = 1000;
-        constexpr int64_t ns_in_ms = ns_in_us * 1000;
-        constexpr int64_t ns_in_s  = ns_in_ms * 1000;
-        constexpr int64_t ns_in_min = 60 * ns_in_s;
-        constexpr int64_t ns_in_hr  = 60 * ns_in_min;
+        [[nodiscard]] bool is_open() const noexcept { return fd >= 0 && map; }
+
+        void write(const Record& record) noexcept override
+        {
+            if (!is_open()) return;
+            try {
+                std::lock_guard lock(mutex);
+                pending_sites.push_back(intern(record.name, record.location));
+                pending_starts.push_back(record.start);
+                pending_durations.push_back(record.get_elapsed());
+                if (pending_sites.size() >= options.block_size) flush_block();
+            } catch (...) {}
+        }
+
+        // Store a merged Registry snapshot, e.g. at the end of a run. Values are in ns, or in
+        // 1/scale ns when the summaries were built from a finer unit (1000 for picoseconds).
+        void write(const std::vector<Registry::Summary>& summaries, std::uint32_t scale = 1)
+        {
+            if (!is_open()) return;
+            std::lock_guard lock(mutex);
+            for (const auto& summary : summaries) {
+                std::uint32_t id = intern(summary.name, summary.location);
+                chunk.clear();
+                detail::binary::put_varint(chunk, id);
+                detail::binary::put_varint(chunk, std::max<std::uint32_t>(scale, 1));
+                detail::binary::put_varint(chunk, summary.count);
+                detail::binary::put_zigzag(chunk, summary.sum);
+                detail::binary::put_zigzag(chunk, summary.min);
+                detail::binary::put_zigzag(chunk, summary.max);
+                auto used = std::count_if(summary.buckets.begin(), summary.buckets.end(), [](auto count) { return count != 0; });
+                detail::binary::put_varint(chunk, static_cast<std::uint64_t>(used));
+                for (std::size_t i = 0; i < summary.buckets.size(); ++i) {
+                    if (!summary.buckets[i]) continue;
+                    detail::binary::put_varint(chunk, i);
+                    detail::binary::put_varint(chunk, summary.buckets[i]);
+                }
+                append_chunk(detail::binary::Chunk::summary, chunk);
+            }
+        }
 
+        // Encode the pending records so readers opening the file now can see them.
+        void flush()
+        {
+            std::lock_guard lock(mutex);
+            flush_block();
+        }
+    };
 
 
-        struct BaseTimerSettings
+    // Maps a BinaryWriter file read-only and iterates it without copying: site strings are
+    // views into the mapping, and records are decoded straight from the columnar blocks.
+    class BinaryReader
+    {
+    public:
+        struct Site
         {
             std::string_view name;
-            std::string format = "[{filename}:{row} in `{function}` -- {name}] -> {result}";
-            bool show_output = true;
-            std::source_location location = std::source_location::current();
-            std::ostream& output_stream = std::cout;
+            std::string_view file;
+            std::string_view function;
+            std::uint32_t line = 0;
+            std::uint32_t column = 0;
+        };
 
+        struct Entry
+        {
+            std::uint32_t site = 0;
+            int64_t start = 0;    // ns since the timer clock's epoch
+            int64_t duration = 0; // ns
+        };
 
-            std::string_view get_name() const noexcept { return name; }
-            std::string_view get_format() const noexcept { return format; }
-            std::string_view get_filename() const noexcept { return location.file_name(); }
-            int get_line() const noexcept { return location.line(); }
-            std::string_view get_function_name() const noexcept { return location.function_name(); }
+        // Stored Registry::Summary, with its site as an index into `get_sites()`. sum, min, max
+        // and the bucket bounds are in 1/scale ns.
+        struct Summary
+        {
+            std::uint32_t site = 0;
+            std::uint32_t scale = 1;
+            std::uint64_t count = 0;
+            int64_t sum = 0;
+            int64_t min = 0;
+            int64_t max = 0;
+            std::array<std::uint64_t, Registry::bucket_count> buckets {};
         };
 
-        class BaseTimerFormatter
+    private:
+        struct Block
         {
-        protected:
-            static const std::string automatic_duration_to_string(int64_t elapsed) noexcept {
-                if (elapsed < ns_in_us) {
-                    return std::to_string(elapsed) + " ns";
-                } else if (elapsed < ns_in_ms) {
-                    return std::to_string(elapsed / 1000.0) + " us";
-                } else if (elapsed < ns_in_s) {
-                    return std::to_string(elapsed / 1'000'000.0) + " ms";
-                } else if (elapsed < ns_in_min) {
-                    return std::to_string(elapsed / 1'000'000'000.0) + " s";
-                } else if (elapsed < ns_in_hr) {
-                    return std::to_string(elapsed / 60'000'000'000.0) + " m";
-                } else {
-                    return std::to_string(elapsed / 3'600'000'000'000.0) + " h";
-                }
-            }
+            std::size_t count;
+            const char* columns[3];
+            const char* end;
+        };
 
-            template <detail::Duration duration>
-            static constexpr std::string_view duration_suffix() {
-                if constexpr (std::same_as<duration, std::chrono::nanoseconds>) return "ns";
-                else if constexpr (std::same_as<duration, std::chrono::microseconds>) return "us";
-                else if constexpr (std::is_same_v<duration, std::chrono::milliseconds>) return "ms";
-                else if constexpr (std::is_same_v<duration, std::chrono::seconds>) return "s";
-                else if constexpr (std::is_same_v<duration, std::chrono::minutes>) return "m";
-                else if constexpr (std::is_same_v<duration, std::chrono::hours>) return "h";
-                else return "unknown";
-            }
+        int fd = -1;
+        const char* map = nullptr;
+        std::size_t size = 0;
+        int version = 0;
+        std::vector<Site> sites;
+        std::vector<Block> blocks;
+        std::vector<Summary> summaries;
 
-            template <typename S>
-            requires std::derived_from<S, BaseTimerSettings>
-            std::string format_output(std::string_view result, S& settings) const noexcept
-            {
-                std::string out = settings.format;
+        void index()
+        {
+            using namespace detail::binary;
+            const char* at = map + magic.size();
+            const char* end = map + size;
+            while (at < end) {
+                auto type = static_cast<Chunk>(*at++);
+                auto length = static_cast<std::size_t>(std::min<std::uint64_t>(get_varint(at, end), static_cast<std::uint64_t>(end - at)));
+                const char* payload = at;
+                const char* payload_end = at + length;
+                at = payload_end;
 
-                auto replace = [&out](const std::string& what, const std::string_view& with) {
-                    size_t pos = 0;
-                    while ((pos = out.find(what, pos)) != std::string::npos) {
-                        out.replace(pos, what.length(), with);
-                        pos += with.length();
+                if (type == Chunk::site) {
+                    auto id = static_cast<std::size_t>(get_varint(payload, payload_end));
+                    if (id >= sites.size()) sites.resize(id + 1);
+                    Site& site = sites[id];
+                    site.name = get_string(payload, payload_end);
+                    site.file = get_string(payload, payload_end);
+                    site.function = get_string(payload, payload_end);
+                    site.line = static_cast<std::uint32_t>(get_varint(payload, payload_end));
+                    site.column = static_cast<std::uint32_t>(get_varint(payload, payload_end));
+                } else if (type == Chunk::block) {
+                    Block block {};
+                    block.count = static_cast<std::size_t>(get_varint(payload, payload_end));
+                    auto first = static_cast<std::size_t>(get_varint(payload, payload_end));
+                    auto second = static_cast<std::size_t>(get_varint(payload, payload_end));
+                    block.columns[0] = payload;
+                    block.columns[1] = std::min(payload + first, payload_end);
+                    block.columns[2] = std::min(block.columns[1] + second, payload_end);
+                    block.end = payload_end;
+                    blocks.push_back(block);
+                } else if (type == Chunk::summary) {
+                    Summary summary;
+                    summary.site = static_cast<std::uint32_t>(get_varint(payload, payload_end));
+                    if (version >= 2) summary.scale = std::max<std::uint32_t>(static_cast<std::uint32_t>(get_varint(payload, payload_end)), 1);
+                    summary.count = get_varint(payload, payload_end);
+                    summary.sum = get_zigzag(payload, payload_end);
+                    summary.min = get_zigzag(payload, payload_end);
+                    summary.max = get_zigzag(payload, payload_end);
+                    auto used = get_varint(payload, payload_end);
+                    for (std::uint64_t i = 0; i < used && payload < payload_end; ++i) {
+                        auto bucket = static_cast<std::size_t>(get_varint(payload, payload_end));
+                        auto count = get_varint(payload, payload_end);
+                        if (bucket < summary.buckets.size()) summary.buckets[bucket] = count;
                     }
-                };
-                replace("{filename}", settings.get_filename());
-                replace("{row}", std::to_string(settings.get_line()));
-                replace("{name}", settings.get_name());
-                replace("{function}", settings.get_function_name());
-                replace("{result}", result);
-                return out;
+                    summaries.push_back(summary);
+                }
             }
-        };
+        }
 
-        template <Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
-        class BaseTimer : public BaseTimerFormatter
+    public:
+        // Iterates records in write order, decoding one row of the three columns per step.
+        class Iterator
         {
-        public:
-            using Settings = BaseTimerSettings;
-
         private:
-            clock::time_point m_start;
-            clock::time_point m_end;
-            Settings settings;
+            const std::vector<Block>* blocks = nullptr;
+            std::size_t block = 0;
+            std::size_t remaining = 0;
+            const char* cursors[3] {};
+            Entry entry;
 
-        protected:
-            BaseTimer(Settings settings) noexcept : settings(settings)
+            void load() noexcept
             {
+                while (remaining == 0) {
+                    if (++block >= blocks->size()) return;
+                    start_block();
+                }
+                decode();
             }
 
-            ~BaseTimer() noexcept = default;
-
-            BaseTimer(const BaseTimer&) = delete;
-            BaseTimer& operator=(const BaseTimer&) = delete;
-            BaseTimer(BaseTimer&&) = delete;
-            BaseTimer& operator=(BaseTimer&&) = delete;
+            void start_block() noexcept
+            {
+                const Block& current = (*blocks)[block];
+                remaining = current.count;
+                for (int i = 0; i < 3; ++i) cursors[i] = current.columns[i];
+            }
 
-            void start_timer() noexcept { m_start = clock::now(); }
-            void end_timer() noexcept { m_end = clock::now(); }
-            void show_result() const noexcept
+            void decode() noexcept
             {
-                if (!settings.show_output) return;
+                using namespace detail::binary;
+                const Block& current = (*blocks)[block];
+                entry.site = static_cast<std::uint32_t>(get_varint(cursors[0], current.columns[1]));
+                entry.start += get_zigzag(cursors[1], current.columns[2]);
+                entry.duration = static_cast<int64_t>(get_varint(cursors[2], current.end));
+            }
 
-                if constexpr (std::is_same_v<duration, automatic_duration>) {
-                    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(m_end - m_start).count();
-                    settings.output_stream << format_output(automatic_duration_to_string(elapsed), settings) << std::endl;
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Entry;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Entry*;
+            using reference = const Entry&;
 
-                } else {
-                    auto elapsed = std::chrono::duration_cast<duration>(m_end - m_start).count();
-                    settings.output_stream << format_output(std::to_string(elapsed) + ' ' + std::string(duration_suffix<duration>()), settings) << std::endl;
-                }
+            Iterator() = default;
+            explicit Iterator(const std::vector<Block>& list) noexcept : blocks(&list)
+            {
+                if (blocks->empty()) return;
+                start_block();
+                if (remaining == 0) load(); else decode();
             }
 
+            reference operator*() const noexcept { return entry; }
+            pointer operator->() const noexcept { return &entry; }
 
-            [[nodiscard]] const auto get_start() const noexcept { return m_start; }
-            [[nodiscard]] const auto get_end() const noexcept { return m_end; }
-            [[nodiscard]] const auto get_elapsed() const noexcept
+            Iterator& operator++() noexcept
             {
-                return std::chrono::duration_cast<std::chrono::nanoseconds>(m_end - m_start).count();
+                --remaining;
+                load();
+                return *this;
             }
+            void operator++(int) noexcept { ++*this; }
 
-
+            // iterators only compare equal to the end once exhausted
+            bool operator==(const Iterator& other) const noexcept
+            {
+                bool done = !blocks || block >= blocks->size();
+                bool other_done = !other.blocks || other.block >= other.blocks->size();
+                return done && other_done;
+            }
         };
 
+        explicit BinaryReader(const std::string& path)
+        {
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
 
-    } // namespace detail
+            struct stat info;
+            if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < detail::binary::magic.size()) return;
+            void* mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) return;
+            map = static_cast<const char*>(mapped);
+            size = static_cast<std::size_t>(info.st_size);
 
+            std::string_view header(map, detail::binary::magic.size());
+            version = header == detail::binary::magic ? 2 : header == detail::binary::magic_v1 ? 1 : 0;
+            if (version == 0) {
+                munmap(const_cast<char*>(map), size);
+                map = nullptr;
+                return;
+            }
+            try { index(); } catch (...) {}
+        }
 
-    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
-    class FunctionTimer : public detail::BaseTimer<duration, clock>
-    {
-    public:
-        using Base = detail::BaseTimer<duration, clock>;
-        using Settings = Base::Settings;
+        ~BinaryReader()
+        {
+            if (map) munmap(const_cast<char*>(map), size);
+            if (fd >= 0) ::close(fd);
+        }
 
-    private:
-        std::any fresult;
+        BinaryReader(const BinaryReader&) = delete;
+        BinaryReader& operator=(const BinaryReader&) = delete;
+        BinaryReader(BinaryReader&&) = delete;
+        BinaryReader& operator=(BinaryReader&&) = delete;
 
-    public:
-        FunctionTimer(const FunctionTimer&) = delete;
-        FunctionTimer& operator=(const FunctionTimer&) = delete;
-        FunctionTimer(FunctionTimer&&) = delete;
-        FunctionTimer& operator=(FunctionTimer&&) = delete;
+        [[nodiscard]] bool is_open() const noexcept { return map != nullptr; }
+        [[nodiscard]] int get_version() const noexcept { return version; } // of the file format, 0 if not open
+        [[nodiscard]] const std::vector<Site>& get_sites() const noexcept { return sites; }
+        [[nodiscard]] const std::vector<Summary>& get_summaries() const noexcept { return summaries; }
 
-        template <typename Callable, typename... Args>
-        FunctionTimer(Settings settings, Callable&& function, Args&&... args) noexcept : Base(settings)
-        {
-            this->start_timer();
-            fresult = std::forward<Callable>(function)(std::forward<Args>(args)...);
-            this->end_timer();
-        }
+        [[nodiscard]] Iterator begin() const noexcept { return Iterator(blocks); }
+        [[nodiscard]] Iterator end() const noexcept { return Iterator(); }
+    };
+#endif // TIMED_HAS_MMAP
 
-        ~FunctionTimer() noexcept
+
+
+    // Benchmarks declared with TIMED_BENCHMARK, in registration order. They are run by the
+    // command-line runner that TIMED_BENCHMARK_MAIN adds to one file (see the end of this header).
+    class BenchmarkRegistry
+    {
+    public:
+        struct Entry
         {
-            this->show_result();
-        }
+            std::string_view name;
+            void (*function)();
+            std::source_location location;
+        };
 
-        template <typename T>
-        [[nodiscard]] const auto get_result() const noexcept
+    private:
+        static std::vector<Entry>& entries() noexcept
         {
-            return std::any_cast<T>(fresult);
+            static std::vector<Entry> registered;
+            return registered;
         }
-        [[nodiscard]] const auto get_result() const noexcept
+
+    public:
+        // Called by TIMED_BENCHMARK during static initialization; the name must outlive the program.
+        static bool add(std::string_view name, void (*function)(), std::source_location location = std::source_location::current())
         {
-            return fresult;
+            entries().push_back({ name, function, location });
+            return true;
         }
 
-        using Base::get_elapsed;
+        [[nodiscard]] static const std::vector<Entry>& get() noexcept { return entries(); }
     };
+} // namespace Timed
 
-    template <size_t N, detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
-    class AverageFunctionTimer : public detail::BaseTimerFormatter
+
+// Registers a benchmark whose body is one iteration, timed in calibrated batches like
+// Timed::Benchmark by the runner:
+//     TIMED_BENCHMARK(sum_floats) { Timed::do_not_optimize(sum(input)); }
+#define TIMED_BENCHMARK(name)                                                                   \
+    static void timed_benchmark_##name();                                                       \
+    [[maybe_unused]] static const bool timed_benchmark_registered_##name =                      \
+        ::Timed::BenchmarkRegistry::add(#name, timed_benchmark_##name);                         \
+    static void timed_benchmark_##name()
+
+
+// Define TIMED_TRACK_ALLOCATIONS before including this header in exactly one source file to
+// replace the global operator new/delete with versions keeping per-thread allocation counters,
+// which timers read when `Settings::allocations` is set. Every block carries a 16-byte header
+// with its size, so the replacements also work for memory from aligned operator new.
+#if defined(TIMED_TRACK_ALLOCATIONS)
+#include <cstddef>          // std::max_align_t
+#include <cstdlib>          // std::malloc, std::free
+#include <new>              // std::align_val_t, std::bad_alloc
+
+namespace Timed::detail
+{
+    struct AllocationHeader
     {
+        void* block;
+        std::size_t size;
+    };
 
+    inline void* tracked_allocate(std::size_t size, std::size_t alignment) noexcept
+    {
+        alignment = std::max(alignment, alignof(std::max_align_t));
+        void* block = std::malloc(size + alignment + sizeof(AllocationHeader));
+        if (!block) return nullptr;
 
-    public:
-        using ChildTimer = FunctionTimer<duration, clock>;
-        using ChildSettings = ChildTimer::Settings;
+        auto address = reinterpret_cast<std::uintptr_t>(block) + sizeof(AllocationHeader);
+        address = (address + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+        auto* header = reinterpret_cast<AllocationHeader*>(address) - 1;
+        *header = { block, size };
 
-        struct Settings: public ChildSettings
-        {
-            bool child_output = false;
+        AllocationState& state = allocation_state();
+        ++state.count;
+        state.bytes += size;
+        state.live += static_cast<int64_t>(size);
+        state.peak = std::max(state.peak, state.live);
+        return reinterpret_cast<void*>(address);
+    }
 
-            // Constructor for the child timer
-            ChildSettings get_settings_t() const
-            {
-                ChildSettings settings = *this;
-                settings.show_output = child_output;
-                return settings;
-            }
-        };
+    inline void* tracked_allocate_or_throw(std::size_t size, std::size_t alignment)
+    {
+        for (;;) {
+            if (void* pointer = tracked_allocate(size, alignment)) return pointer;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
 
-    private:
-            std::array<int64_t, N> timers;
-            std::array<std::any, N> fresults;
-            Settings settings;
+    inline void tracked_free(void* pointer) noexcept
+    {
+        if (!pointer) return;
+        auto* header = static_cast<AllocationHeader*>(pointer) - 1;
+        allocation_state().live -= static_cast<int64_t>(header->size);
+        std::free(header->block);
+    }
 
-            int64_t max_time = std::numeric_limits<int64_t>::min();
-            int64_t min_time = std::numeric_limits<int64_t>::max();
-            int64_t median_time = 0;
-            int64_t total_time = 0;
+    inline const bool allocation_hooks_installed = (allocation_hooks().store(true), true);
+} // namespace Timed::detail
 
-    public:
-        AverageFunctionTimer(const AverageFunctionTimer&) = delete;
-        AverageFunctionTimer& operator=(const AverageFunctionTimer&) = delete;
-        AverageFunctionTimer(AverageFunctionTimer&&) = delete;
-        AverageFunctionTimer& operator=(AverageFunctionTimer&&) = delete;
+void* operator new(std::size_t size) { return Timed::detail::tracked_allocate_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return Timed::detail::tracked_allocate_or_throw(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return Timed::detail::tracked_allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return Timed::detail::tracked_allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return Timed::detail::tracked_allocate_or_throw(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return Timed::detail::tracked_allocate_or_throw(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Timed::detail::tracked_allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Timed::detail::tracked_allocate(size, static_cast<std::size_t>(alignment)); }
 
-        template <typename Callable, typename... Args>
-        AverageFunctionTimer(Settings settings, Callable&& function, Args&&... args) : settings(settings)
-        {
-            for (size_t i = 0; i < N; ++i) {
-                ChildSettings timer_settings = this->settings.get_settings_t();
-                ChildTimer timer(std::move(timer_settings), function, std::forward<Args>(args)...);
-                int64_t t = timer.get_elapsed();
-                timers[i] = t;
-                fresults[i] = timer.get_result();
-                total_time += t;
-                max_time = std::max(max_time, t);
-                min_time = std::min(min_time, t);
-            }
-
-            std::sort(timers.begin(), timers.end());
-            if constexpr ((N & 1) == 0) {
-                median_time = (timers[N / 2 - 1] + timers[N / 2]) / 2;
-            } else {
-                median_time = timers[N / 2];
-            }
+void operator delete(void* pointer) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete[](void* pointer) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { Timed::detail::tracked_free(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { Timed::detail::tracked_free(pointer); }
+#endif // TIMED_TRACK_ALLOCATIONS
+
+
+// Define TIMED_BENCHMARK_MAIN before including this header in exactly one source file to add
+// a `main` running every TIMED_BENCHMARK of the program; `--help` lists the options. With
+// `--parallel`, benchmarks run concurrently, one per isolated CPU (`isolcpus=` or `--cpus=`)
+// with a single CPU kept per SMT core, as only cores nothing else runs on keep results valid.
+#if defined(TIMED_BENCHMARK_MAIN)
+#include <regex>            // std::regex, std::regex_search
+
+namespace Timed::detail
+{
+    struct RunnerOptions
+    {
+        std::string filter;
+        std::size_t repetitions = 1;
+        std::size_t samples = 30;
+        std::chrono::milliseconds warmup { 100 };
+        std::string format = "console";
+        std::string output;
+        bool parallel = false;
+        std::vector<int> cpus;
+        int cpu = -1;
+        bool raise_priority = false;
+        bool warnings = false;
+        bool list = false;
+    };
+
+    struct RunnerResult
+    {
+        const BenchmarkRegistry::Entry* entry = nullptr;
+        std::size_t repetition = 1; // from 1
+        std::size_t iterations = 0;
+        std::size_t batch_size = 0;
+        double mean = 0; // ns per call
+        double median = 0;
+        double min = 0;
+        double max = 0;
+        double error = 0;
+        std::vector<double> samples;
+    };
+
+    // Parse a Linux CPU list such as "2,4-7"; invalid parts are skipped.
+    inline std::vector<int> parse_cpu_list(std::string_view text)
+    {
+        std::vector<int> cpus;
+        while (!text.empty()) {
+            std::string_view part = text.substr(0, text.find(','));
+            text.remove_prefix(std::min(part.size() + 1, text.size()));
+            int first = -1, last = -1;
+            auto [end, ec] = std::from_chars(part.data(), part.data() + part.size(), first);
+            if (ec != std::errc {}) continue;
+            last = first;
+            if (end < part.data() + part.size() && *end == '-') std::from_chars(end + 1, part.data() + part.size(), last);
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
         }
+        return cpus;
+    }
 
-        ~AverageFunctionTimer()
+    // Keeps the first CPU of every SMT core, so no two parallel benchmarks share a core.
+    inline std::vector<int> one_cpu_per_core(const std::vector<int>& cpus)
+    {
+        std::vector<int> kept;
+        std::vector<int> taken;
+        for (int cpu : cpus) {
+            if (std::find(taken.begin(), taken.end(), cpu) != taken.end()) continue;
+            kept.push_back(cpu);
+            std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+            std::string siblings;
+            std::getline(file, siblings);
+            for (int sibling : parse_cpu_list(siblings)) taken.push_back(sibling);
+            taken.push_back(cpu);
+        }
+        return kept;
+    }
+
+    class RunnerOutput : protected BaseTimerFormatter
+    {
+    public:
+        static void write_console(std::ostream& out, const std::vector<RunnerResult>& results)
         {
-            if (!settings.show_output) return;
+            std::size_t width = 9;
+            for (const RunnerResult& result : results) width = std::max(width, result.entry->name.size() + 4);
+            const bool repeated = std::any_of(results.begin(), results.end(), [](const RunnerResult& result) { return result.repetition > 1; });
 
-            if constexpr (std::is_same_v<duration, automatic_duration>) {
-                auto average_time = std::accumulate(timers.begin(), timers.end(), 0LL) / N;
-                settings.output_stream << format_output(automatic_duration_to_string(average_time), settings) << std::endl;
-            } else {
-                auto average_time = std::accumulate(timers.begin(), timers.end(), 0LL) / N;
-                settings.output_stream << format_output(std::to_string(average_time) + ' ' + std::string(duration_suffix<duration>()), settings) << std::endl;
+            auto cell = [&](std::string_view text, std::size_t size, bool left = false) {
+                if (left) out << text;
+                for (std::size_t i = text.size(); i < size; ++i) out.put(' ');
+                if (!left) out << text;
+            };
+            cell("benchmark", width, true);
+            cell("time/call", 16); cell("+/-", 16); cell("iterations", 14); cell("batch", 10);
+            out << '\n';
+            for (const RunnerResult& result : results) {
+                DurationBuffer buffer;
+                std::string name(result.entry->name);
+                if (repeated) name += "/" + std::to_string(result.repetition);
+                cell(name, width, true);
+                cell(duration_to_chars<automatic_duration>(buffer, result.mean), 16);
+                cell(duration_to_chars<automatic_duration>(buffer, result.error), 16);
+                cell(std::to_string(result.iterations), 14);
+                cell(std::to_string(result.batch_size), 10);
+                out << '\n';
             }
         }
 
-        template <typename T>
-        [[nodiscard]] const auto get_result(size_t index) const noexcept
+        static void write_json(std::ostream& out, const std::vector<RunnerResult>& results, const Environment::Metadata& context)
         {
-            static_assert(index < N, "Index out of bounds");
-            return std::any_cast<T>(fresults[index]);
+            out << "{\n\"context\": ";
+            context.write_json(out);
+            out << ",\n\"benchmarks\": [";
+            bool first = true;
+            for (const RunnerResult& result : results) {
+                out << (first ? "\n" : ",\n") << "{\"name\":\"";
+                write_escaped(out, result.entry->name);
+                out << "\",\"file\":\"";
+                write_escaped(out, result.entry->location.file_name());
+                out << "\",\"line\":" << result.entry->location.line() << ",\"repetition\":" << result.repetition
+                    << ",\"iterations\":" << result.iterations << ",\"batch_size\":" << result.batch_size;
+                number(out << ",\"mean_ns\":", result.mean);
+                number(out << ",\"median_ns\":", result.median);
+                number(out << ",\"min_ns\":", result.min);
+                number(out << ",\"max_ns\":", result.max);
+                number(out << ",\"error_ns\":", result.error);
+                out << '}';
+                first = false;
+            }
+            out << "\n]}\n";
         }
-        [[nodiscard]] const auto get_result(size_t index) const noexcept
+
+        static void write_csv(std::ostream& out, const std::vector<RunnerResult>& results)
         {
-            static_assert(index < N, "Index out of bounds");
-            return fresults[index];
+            out << "name,repetition,iterations,batch_size,mean_ns,median_ns,min_ns,max_ns,error_ns\n";
+            for (const RunnerResult& result : results) {
+                out << '"';
+                for (char c : result.entry->name) out << (c == '"' ? "\"\"" : std::string_view(&c, 1));
+                out << "\"," << result.repetition << ',' << result.iterations << ',' << result.batch_size;
+                for (double value : { result.mean, result.median, result.min, result.max, result.error }) number(out << ',', value);
+                out << '\n';
+            }
         }
 
-        [[nodiscard]] const auto get_max_time() const noexcept { return max_time; }
-        [[nodiscard]] const auto get_min_time() const noexcept { return min_time; }
-        [[nodiscard]] const auto get_median_time() const noexcept { return median_time; }
-        [[nodiscard]] const auto get_total_time() const noexcept { return total_time; }
-        [[nodiscard]] const auto get_average_time() const noexcept
+    private:
+        static void number(std::ostream& out, double value)
         {
-            return std::accumulate(timers.begin(), timers.end(), 0LL) / N;
+            char buffer[32];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 3);
+            out.write(buffer, end - buffer);
         }
     };
 
+    inline RunnerResult run_benchmark(const BenchmarkRegistry::Entry& entry, std::size_t repetition, const RunnerOptions& options)
+    {
+        typename Benchmark<>::Settings settings;
+        settings.name = entry.name;
+        settings.location = entry.location;
+        settings.show_output = false;
+        settings.samples = options.samples;
+        settings.warmup = options.warmup;
 
-    template <detail::Duration duration = automatic_duration, typename clock = std::chrono::steady_clock>
-    class BlockTimer : public detail::BaseTimer<duration, clock>
+        Benchmark<> benchmark(settings, entry.function);
+        return { &entry, repetition, benchmark.get_iterations(), benchmark.get_batch_size(), benchmark.get_average_time(),
+                 benchmark.get_median_time(), benchmark.get_min_time(), benchmark.get_max_time(), benchmark.get_error(),
+                 benchmark.get_samples() };
+    }
+
+    inline void print_runner_usage(std::ostream& out, std::string_view program)
     {
-    public:
-        using Base = detail::BaseTimer<duration, clock>;
-        using Settings = typename Base::Settings;
+        out << "usage: " << program << " [options]\n"
+               "  --filter=REGEX        run benchmarks whose name matches (ECMAScript, partial match)\n"
+               "  --repetitions=N       run each benchmark N times (default 1)\n"
+               "  --samples=N           timed batches per run (default 30)\n"
+               "  --warmup=MS           warm-up time per run in milliseconds (default 100)\n"
+               "  --format=FORMAT       console, json, csv or binary (default console)\n"
+               "  --output=PATH         write results to PATH instead of stdout; required for binary\n"
+               "  --cpu=N               pin the benchmark thread to CPU N\n"
+               "  --parallel            run benchmarks concurrently on isolated CPUs\n"
+               "  --cpus=LIST           CPUs for --parallel, e.g. 2,4-7 (default: the isolated CPUs)\n"
+               "  --raise-priority      run at nice -20; needs CAP_SYS_NICE or root\n"
+               "  --warnings            print environment warnings (governor, turbo, priority) to stderr;\n"
+               "                        json results always list them in the context\n"
+               "  --list                print the names of the matching benchmarks and exit\n"
+               "  --help                print this message\n";
+    }
 
-        BlockTimer(const BlockTimer&) = delete;
-        BlockTimer& operator=(const BlockTimer&) = delete;
-        BlockTimer(BlockTimer&&) = delete;
-        BlockTimer& operator=(BlockTimer&&) = delete;
+    // Returns false, after printing why, when the arguments are invalid.
+    inline bool parse_runner_options(int argc, char** argv, RunnerOptions& options)
+    {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view argument = argv[i];
+            std::string_view value;
+            if (auto equals = argument.find('='); equals != std::string_view::npos) {
+                value = argument.substr(equals + 1);
+                argument = argument.substr(0, equals);
+            }
+            auto count = [&](auto& target) {
+                auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), target);
+                return ec == std::errc {} && end == value.data() + value.size();
+            };
 
-        BlockTimer(Settings settings) noexcept : Base(settings)
-        {
-            this->start_timer();
+            bool valid = true;
+            if (argument == "--filter") options.filter = value;
+            else if (argument == "--repetitions") valid = count(options.repetitions) && options.repetitions > 0;
+            else if (argument == "--samples") valid = count(options.samples) && options.samples > 0;
+            else if (argument == "--warmup") {
+                std::int64_t milliseconds = 0;
+                valid = count(milliseconds) && milliseconds >= 0;
+                options.warmup = std::chrono::milliseconds(milliseconds);
+            }
+            else if (argument == "--format") {
+                options.format = value;
+                valid = value == "console" || value == "json" || value == "csv" || value == "binary";
+            }
+            else if (argument == "--output") options.output = value;
+            else if (argument == "--cpu") valid = count(options.cpu) && options.cpu >= 0;
+            else if (argument == "--parallel") options.parallel = true;
+            else if (argument == "--cpus") valid = !(options.cpus = parse_cpu_list(value)).empty();
+            else if (argument == "--raise-priority") options.raise_priority = true;
+            else if (argument == "--warnings") options.warnings = true;
+            else if (argument == "--list") options.list = true;
+            else if (argument == "--help") {
+                print_runner_usage(std::cout, argv[0]);
+                std::exit(0);
+            }
+            else valid = false;
+
+            if (!valid) {
+                std::cerr << "invalid argument: " << argv[i] << '\n';
+                print_runner_usage(std::cerr, argv[0]);
+                return false;
+            }
         }
-        ~BlockTimer() noexcept = default;
+        if (options.format == "binary" && options.output.empty()) {
+            std::cerr << "--format=binary needs --output=PATH\n";
+            return false;
+        }
+        return true;
+    }
+} // namespace Timed::detail
 
-        void end() noexcept
-        {
-            this->end_timer();
+namespace Timed
+{
+    // The runner behind TIMED_BENCHMARK_MAIN: 0 on success, 1 when nothing matched or the
+    // output could not be written, 2 on invalid arguments.
+    inline int run_benchmarks(int argc, char** argv)
+    {
+        detail::RunnerOptions options;
+        if (!detail::parse_runner_options(argc, argv, options)) return 2;
+
+        std::vector<const BenchmarkRegistry::Entry*> selected;
+        try {
+            std::regex filter(options.filter);
+            for (const auto& entry : BenchmarkRegistry::get())
+                if (std::regex_search(entry.name.begin(), entry.name.end(), filter)) selected.push_back(&entry);
+        } catch (const std::regex_error& error) {
+            std::cerr << "invalid --filter: " << error.what() << '\n';
+            return 2;
+        }
+        if (options.list) {
+            for (const auto* entry : selected) std::cout << entry->name << '\n';
+            return 0;
+        }
+        if (selected.empty()) {
+            std::cerr << "no benchmark matches the filter\n";
+            return 1;
         }
 
+        std::vector<int> cpus;
+        if (options.parallel) {
+            std::vector<int> candidates = options.cpus;
+            if (candidates.empty()) {
+                std::ifstream isolated("/sys/devices/system/cpu/isolated");
+                std::string list;
+                std::getline(isolated, list);
+                candidates = detail::parse_cpu_list(list);
+            }
+            cpus = detail::one_cpu_per_core(candidates);
+            if (cpus.size() < 2) {
+                std::cerr << "Timed: fewer than two isolated cores, running benchmarks one at a time\n";
+                cpus.clear();
+            }
+        }
 
-        void end_and_show_result() noexcept
-        {
-            this->end_timer();
-            this->show_result();
+        Environment environment({ cpus.empty() ? options.cpu : -1, options.raise_priority, options.warnings });
+        std::vector<detail::RunnerResult> results(selected.size() * options.repetitions);
+        auto job = [&](std::size_t index) {
+            results[index] = detail::run_benchmark(*selected[index / options.repetitions],
+                                                    index % options.repetitions + 1, options);
+        };
+
+        if (cpus.empty()) {
+            for (std::size_t i = 0; i < results.size(); ++i) job(i);
+        } else {
+            std::atomic<std::size_t> next { 0 };
+            std::vector<std::thread> workers;
+            for (std::size_t w = 0; w < std::min(cpus.size(), results.size()); ++w) {
+                workers.emplace_back([&, cpu = cpus[w]] {
+                    Environment pinned({ cpu, options.raise_priority, false });
+                    for (std::size_t i; (i = next.fetch_add(1)) < results.size();) job(i);
+                });
+            }
+            for (auto& worker : workers) worker.join();
         }
 
-        using Base::show_result;
-        using Base::get_elapsed;
-    };
+        if (options.format == "binary") {
+#if TIMED_HAS_MMAP
+            // One summary per benchmark, over the per-call times of all its samples and repetitions.
+            // Those are batch averages, often below a nanosecond, so they are stored in picoseconds
+            // with the summaries' scale set to 1000.
+            std::vector<Registry::Summary> summaries;
+            for (std::size_t i = 0; i < selected.size(); ++i) {
+                Registry::Summary summary { selected[i]->name, selected[i]->location };
+                for (std::size_t r = 0; r < options.repetitions; ++r) {
+                    for (double sample : results[i * options.repetitions + r].samples) {
+                        auto value = static_cast<int64_t>(std::llround(sample * 1000));
+                        ++summary.count;
+                        summary.sum += value;
+                        summary.min = std::min(summary.min, value);
+                        summary.max = std::max(summary.max, value);
+                        ++summary.buckets[std::min<std::size_t>(std::bit_width(static_cast<std::uint64_t>(std::max<int64_t>(value, 0))),
+                                                                Registry::bucket_count - 1)];
+                    }
+                }
+                summaries.push_back(summary);
+            }
+            BinaryWriter writer(options.output);
+            if (!writer.is_open()) {
+                std::cerr << "cannot write " << options.output << '\n';
+                return 1;
+            }
+            writer.write(summaries, 1000);
+            writer.flush();
+            return 0;
+#else
+            std::cerr << "binary results need POSIX mmap\n";
+            return 1;
+#endif
+        }
 
+        std::ofstream file;
+        if (!options.output.empty()) {
+            file.open(options.output, std::ios::trunc);
+            if (!file) {
+                std::cerr << "cannot write " << options.output << '\n';
+                return 1;
+            }
+        }
+        std::ostream& out = options.output.empty() ? std::cout : file;
+        if (options.format == "json") detail::RunnerOutput::write_json(out, results, environment.get_metadata());
+        else if (options.format == "csv") detail::RunnerOutput::write_csv(out, results);
+        else detail::RunnerOutput::write_console(out, results);
+        out.flush();
+        return out ? 0 : 1;
+    }
 } // namespace Timed
+
+int main(int argc, char** argv)
+{
+    return Timed::run_benchmarks(argc, argv);
+}
+#endif // TIMED_BENCHMARK_MAIN